@@ -0,0 +1,350 @@
+#pragma once
+#if false
+#include <lib/channel.hpp>
+#include <lib/raw.storage.hpp>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <utility>
+
+/// Ленивые адаптеры каналов для чтения: преобразование выполняется в poll/peek/next
+/// того потока, который читает, без промежуточных каналов, потоков и аллокаций.
+///     auto pipeline = lib::chunk<64>(lib::filter(lib::map(input, parse), valid));
+/// Lvalue-канал адаптер хранит по ссылке, rvalue (другой адаптер) - по значению.
+namespace lib {
+    namespace details {
+        template <class Channel>
+        class Source
+        {
+            mutable Channel channel;
+        public:
+            explicit Source(Channel&& channel) noexcept(std::is_nothrow_move_constructible_v<Channel>)
+            : channel(std::move(channel))
+            {}
+            Channel& operator*() const noexcept
+            {
+                return channel;
+            }
+            Channel* operator->() const noexcept
+            {
+                return &channel;
+            }
+        };
+
+        template <class Channel>
+        class Source<Channel&>
+        {
+            Channel* channel;
+        public:
+            explicit Source(Channel& channel) noexcept
+            : channel(&channel)
+            {}
+            Channel& operator*() const noexcept
+            {
+                return *channel;
+            }
+            Channel* operator->() const noexcept
+            {
+                return channel;
+            }
+        };
+
+        template <class Channel>
+        using SourceEvent = std::remove_reference_t<decltype(std::declval<const std::remove_reference_t<Channel>&>().event())>;
+
+        template <class Channel>
+        using SourceValue = std::remove_cvref_t<decltype(std::declval<std::remove_reference_t<Channel>&>().peek())>;
+    }
+
+    template <class Channel, class Function>
+    class MapChannel: public IChannelBase<MapChannel<Channel, Function>>
+    {
+        details::Source<Channel> source;
+        [[no_unique_address]] Function function;
+    public:
+        using Type = std::invoke_result_t<const Function&, decltype(source->peek())>;
+        using Event = details::SourceEvent<Channel>;
+    public:
+        MapChannel(Channel&& channel, Function function)
+        : source(std::forward<Channel>(channel))
+        , function(std::move(function))
+        {}
+
+        std::size_t poll() const noexcept
+        {
+            return source->poll();
+        }
+        Type peek()
+        {
+            return std::invoke(function, source->peek());
+        }
+        void next()
+        {
+            source->next();
+        }
+        Event& event() const noexcept
+        {
+            return source->event();
+        }
+        bool closed() const noexcept
+        {
+            return source->closed();
+        }
+        void close() noexcept
+        {
+            source->close();
+        }
+    };
+
+    template <class Channel, class Function>
+    MapChannel<Channel, Function> map(Channel&& channel, Function function)
+    {
+        return {std::forward<Channel>(channel), std::move(function)};
+    }
+
+    /// poll() пропускает сообщения, не прошедшие проверку, и возвращает не больше 1:
+    /// о следующих сообщениях источника заранее ничего не известно. Прошедшее
+    /// сообщение забирается из источника в poll(), поэтому peek() источника
+    /// (например, функция map()) вызывается для каждого сообщения один раз.
+    template <class Channel, class Predicate>
+    class FilterChannel: public IChannelBase<FilterChannel<Channel, Predicate>>
+    {
+        using Value = details::SourceValue<Channel>;
+
+        details::Source<Channel> source;
+        [[no_unique_address]] Predicate predicate;
+        mutable RawStorage<Value> value;
+        mutable bool matched = false;
+    public:
+        using Type = Value&;
+        using Event = details::SourceEvent<Channel>;
+    public:
+        FilterChannel(Channel&& channel, Predicate predicate)
+        : source(std::forward<Channel>(channel))
+        , predicate(std::move(predicate))
+        {}
+        FilterChannel(FilterChannel&& other)
+        : source(std::move(other.source))
+        , predicate(std::move(other.predicate))
+        {
+            if (other.matched) {
+                value.emplace(std::move(*other.value.ptr()));
+                matched = true;
+                other.next();
+            }
+        }
+        ~FilterChannel() noexcept
+        {
+            next();
+        }
+
+        std::size_t poll() const
+        {
+            while (!matched && source->poll()) {
+                auto&& current = source->peek();
+                if (std::invoke(predicate, std::as_const(current))) {
+                    value.emplace(std::move(current));
+                    matched = true;
+                }
+                source->next();
+            }
+            return matched ? 1 : 0;
+        }
+        Type peek() noexcept
+        {
+            return *value.ptr();
+        }
+        void next() noexcept
+        {
+            if (matched) {
+                value.destroy();
+                matched = false;
+            }
+        }
+        Event& event() const noexcept
+        {
+            return source->event();
+        }
+        bool closed() const noexcept
+        {
+            return !matched && source->closed();
+        }
+        void close() noexcept
+        {
+            source->close();
+        }
+    };
+
+    template <class Channel, class Predicate>
+    FilterChannel<Channel, Predicate> filter(Channel&& channel, Predicate predicate)
+    {
+        return {std::forward<Channel>(channel), std::move(predicate)};
+    }
+
+    /// Собирает по N сообщений во встроенный буфер, peek() возвращает Span на него.
+    /// Если источник закрыт, последняя пачка может быть неполной. Сообщения
+    /// создаются в буфере по мере прихода, конструктор по умолчанию им не нужен.
+    template <class Channel, std::size_t N>
+    class ChunkChannel: public IChannelBase<ChunkChannel<Channel, N>>
+    {
+        using Value = details::SourceValue<Channel>;
+
+        details::Source<Channel> source;
+        mutable std::array<RawStorage<Value>, N> buffer;
+        mutable std::size_t size = 0;
+    public:
+        using Type = Span<Value>;
+        using Event = details::SourceEvent<Channel>;
+    public:
+        explicit ChunkChannel(Channel&& channel)
+        : source(std::forward<Channel>(channel))
+        {}
+        ChunkChannel(ChunkChannel&& other)
+        : source(std::move(other.source))
+        {
+            for (; size < other.size; ++size) {
+                buffer[size].emplace(std::move(*other.buffer[size].ptr()));
+            }
+            other.next();
+        }
+        ~ChunkChannel() noexcept
+        {
+            next();
+        }
+
+        std::size_t poll() const
+        {
+            while (size < N && source->poll()) {
+                buffer[size++].emplace(std::move(source->peek()));
+                source->next();
+            }
+            return size == N || (size != 0 && source->closed()) ? 1 : 0;
+        }
+        Type peek() noexcept
+        {
+            return Type(buffer[0].ptr(), size);
+        }
+        void next() noexcept
+        {
+            for (std::size_t i = 0; i < size; ++i) {
+                buffer[i].destroy();
+            }
+            size = 0;
+        }
+        Event& event() const noexcept
+        {
+            return source->event();
+        }
+        bool closed() const noexcept
+        {
+            return size == 0 && source->closed();
+        }
+        void close() noexcept
+        {
+            source->close();
+        }
+    };
+
+    template <std::size_t N, class Channel>
+    ChunkChannel<Channel, N> chunk(Channel&& channel)
+    {
+        return ChunkChannel<Channel, N>(std::forward<Channel>(channel));
+    }
+
+    /// Как ChunkChannel, но пачка отдаётся и неполной, если с первого её сообщения
+    /// прошло duration. Событие включает таймер, поэтому подписчику нужны часы:
+    ///     Subscriber subscriber(window.event(), clock);
+    /// Событие ссылается на таймер внутри объекта, поэтому адаптер не перемещается.
+    template <class Channel, std::size_t N>
+    class WindowChannel: public IChannelBase<WindowChannel<Channel, N>>
+    {
+        using Value = details::SourceValue<Channel>;
+        using TimePoint = TimeEvent::TimePoint;
+        using Duration = TimeEvent::Chrono::duration;
+
+        details::Source<Channel> source;
+        Duration duration;
+        TimeEvent::IClock& clock;
+
+        mutable std::array<RawStorage<Value>, N> buffer;
+        mutable std::size_t size = 0;
+        mutable TimePoint deadline = TimePoint::max();
+        mutable TimeEvent timer;
+    public:
+        using Type = Span<Value>;
+        using Event = EventMux<details::SourceEvent<Channel>, TimeEvent>;
+    private:
+        mutable Event events;
+    public:
+        WindowChannel(Channel&& channel, Duration duration, TimeEvent::IClock& clock)
+        : source(std::forward<Channel>(channel))
+        , duration(duration)
+        , clock(clock)
+        , events(source->event(), timer)
+        {}
+        WindowChannel(const WindowChannel&) = delete;
+        WindowChannel& operator=(const WindowChannel&) = delete;
+        ~WindowChannel() noexcept
+        {
+            for (std::size_t i = 0; i < size; ++i) {
+                buffer[i].destroy();
+            }
+        }
+
+        std::size_t poll() const
+        {
+            while (size < N && source->poll()) {
+                if (size == 0) {
+                    deadline = clock.now() + duration;
+                    timer.emit_on(deadline);
+                }
+                buffer[size++].emplace(std::move(source->peek()));
+                source->next();
+            }
+            if (size == N) {
+                return 1;
+            }
+            return size != 0 && (clock.now() >= deadline || source->closed()) ? 1 : 0;
+        }
+        Type peek() noexcept
+        {
+            return Type(buffer[0].ptr(), size);
+        }
+        void next()
+        {
+            for (std::size_t i = 0; i < size; ++i) {
+                buffer[i].destroy();
+            }
+            size = 0;
+            deadline = TimePoint::max();
+            timer.emit_on(deadline);
+        }
+        Event& event() const noexcept
+        {
+            return events;
+        }
+        bool closed() const noexcept
+        {
+            return size == 0 && source->closed();
+        }
+        void close() noexcept
+        {
+            source->close();
+        }
+    };
+
+    template <std::size_t N, class Channel>
+    WindowChannel<Channel, N> window(Channel&& channel, TimeEvent::Chrono::duration duration, TimeEvent::IClock& clock)
+    {
+        return {std::forward<Channel>(channel), duration, clock};
+    }
+
+    /// Сообщения всех каналов парами (кортежами); готово, когда есть в каждом.
+    template <class ...Channels>
+    ChannelAll<Channels...> zip(Channels& ...channels) noexcept
+    {
+        return ChannelAll<Channels...>(channels...);
+    }
+}
+#endif
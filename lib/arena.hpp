@@ -0,0 +1,187 @@
+#pragma once
+#include <lib/typename.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+
+namespace lib {
+
+    /// Монотонная арена: память выдаётся сдвигом указателя, deallocate ничего
+    /// не делает, всё освобождается сразу через release() или откатом к mark().
+    /// Блоки берутся у upstream, каждый следующий вдвое больше предыдущего.
+    /// Не потокобезопасна: одна арена - на один запрос или одну задачу.
+    class Arena: public std::pmr::memory_resource
+    {
+        struct Chunk
+        {
+            Chunk*      prev;
+            std::size_t size;
+
+            std::byte* begin() noexcept
+            {
+                return reinterpret_cast<std::byte*>(this + 1);
+            }
+            std::byte* end() noexcept
+            {
+                return reinterpret_cast<std::byte*>(this) + size;
+            }
+        };
+
+        std::pmr::memory_resource* upstream;
+        std::byte*  initial;
+        std::size_t initial_size;
+        std::size_t chunk_size;
+        std::size_t next_size;
+
+        Chunk*     chunks  = nullptr;
+        std::byte* current = nullptr;
+        std::byte* limit   = nullptr;
+    public:
+        /// Состояние арены для отката: всё, что выделено после mark(), освобождает rewind().
+        struct Mark
+        {
+            Chunk*     chunk;
+            std::byte* current;
+        };
+
+        class Scope;
+    public:
+        explicit Arena(std::size_t chunk_size = 4096, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+        : Arena(nullptr, 0, chunk_size, upstream)
+        {}
+        /// Сначала используется внешний буфер (например, на стеке), затем блоки upstream.
+        Arena(void* buffer, std::size_t size, std::size_t chunk_size = 4096, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+        : upstream(upstream)
+        , initial(static_cast<std::byte*>(buffer))
+        , initial_size(size)
+        , chunk_size(std::max(chunk_size, 2 * sizeof(Chunk)))
+        , next_size(this->chunk_size)
+        , current(initial)
+        , limit(initial + size)
+        {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena() noexcept override
+        {
+            release();
+        }
+    public:
+        [[nodiscard]] Mark mark() const noexcept
+        {
+            return Mark{chunks, current};
+        }
+        void rewind(Mark mark) noexcept
+        {
+            while (chunks != mark.chunk) {
+                auto* chunk = std::exchange(chunks, chunks->prev);
+                upstream->deallocate(chunk, chunk->size, alignof(Chunk));
+            }
+            current = mark.current;
+            limit = chunks != nullptr ? chunks->end() : initial + initial_size;
+        }
+        /// Освобождает все блоки upstream; внешний буфер снова доступен целиком.
+        void release() noexcept
+        {
+            rewind(Mark{nullptr, initial});
+            next_size = chunk_size;
+        }
+        [[nodiscard]] std::pmr::memory_resource* upstream_resource() const noexcept
+        {
+            return upstream;
+        }
+    private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override
+        {
+            void* pointer = current;
+            std::size_t space = limit - current;
+            if (current == nullptr || std::align(alignment, size, pointer, space) == nullptr) {
+                grow(size + alignment);
+                pointer = current;
+                space = limit - current;
+                std::align(alignment, size, pointer, space);
+            }
+            current = static_cast<std::byte*>(pointer) + size;
+            return pointer;
+        }
+        void do_deallocate(void*, std::size_t, std::size_t) noexcept override
+        {}
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        void grow(std::size_t size)
+        {
+            const auto bytes = std::max(next_size, size + sizeof(Chunk));
+            auto* chunk = static_cast<Chunk*>(upstream->allocate(bytes, alignof(Chunk)));
+            chunks = new (chunk) Chunk{chunks, bytes};
+            current = chunk->begin();
+            limit = chunk->end();
+            next_size = std::min(next_size * 2, std::size_t(1) << 24U);
+        }
+    };
+
+    /// Откатывает арену к состоянию на момент создания.
+    class Arena::Scope
+    {
+        Arena& arena;
+        Mark   saved;
+    public:
+        explicit Scope(Arena& arena) noexcept
+        : arena(arena)
+        , saved(arena.mark())
+        {}
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() noexcept
+        {
+            arena.rewind(saved);
+        }
+    };
+
+    unittest {
+        alignas(std::max_align_t) std::byte buffer[64];
+        Arena arena(buffer, sizeof(buffer), 256);
+
+        void* a = arena.allocate(16, 8);
+        void* b = arena.allocate(8, 8);
+        check(a == buffer);
+        check(b == buffer + 16);
+
+        void* aligned = arena.allocate(1, 32);
+        check(reinterpret_cast<std::uintptr_t>(aligned) % 32 == 0);
+
+        const auto mark = arena.mark();
+        void* big = arena.allocate(1000, 16);
+        check(reinterpret_cast<std::uintptr_t>(big) % 16 == 0);
+        arena.rewind(mark);
+        check(arena.mark().chunk == mark.chunk && arena.mark().current == mark.current);
+
+        {
+            Arena::Scope scope(arena);
+            std::pmr::vector<int> numbers(&arena);
+            for (int i = 0; i < 100; ++i) {
+                numbers.push_back(i);
+            }
+            check(numbers[99] == 99);
+        }
+        check(arena.mark().current == mark.current);
+
+        arena.release();
+        check(arena.allocate(4, 4) == buffer);
+    }
+}
+
+namespace lib {
+    template <>
+    struct TypeName<Arena>
+    {
+        constexpr static inline StaticString name = "lib::Arena";
+    };
+}
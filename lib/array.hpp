@@ -83,6 +83,10 @@ namespace lib {
     public:
         constexpr Span() = default;
 
+        constexpr Span(T* ptr, std::size_t size) noexcept
+        : m_ptr(ptr), m_size(size)
+        {}
+
         template <std::size_t N>
         constexpr Span(T(&array)[N]) noexcept // NOLINT
         : m_ptr(array), m_size(N)
@@ -115,6 +119,10 @@ namespace lib {
         {
             return m_size;
         }
+        constexpr bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
         constexpr auto begin() const noexcept
         {
             return m_ptr;
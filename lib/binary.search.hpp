@@ -0,0 +1,343 @@
+#pragma once
+#include <lib/typename.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define LIB_BINARY_SEARCH_SSE2 1
+#else
+#   define LIB_BINARY_SEARCH_SSE2 0
+#endif
+
+
+namespace lib {
+
+    namespace details {
+        constexpr inline std::size_t cache_line = 64;
+
+        inline void prefetch(const void* address) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(address);
+#elif LIB_BINARY_SEARCH_SSE2
+            _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+            (void)address;
+#endif
+        }
+
+        template <class T>
+        struct CacheLineAllocator
+        {
+            using value_type = T;
+
+            CacheLineAllocator() noexcept = default;
+            template <class U>
+            CacheLineAllocator(const CacheLineAllocator<U>&) noexcept // NOLINT
+            {}
+
+            T* allocate(std::size_t count)
+            {
+                return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(cache_line)));
+            }
+            void deallocate(T* pointer, std::size_t count) noexcept
+            {
+                ::operator delete(pointer, count * sizeof(T), std::align_val_t(cache_line));
+            }
+
+            friend bool operator==(const CacheLineAllocator&, const CacheLineAllocator&) noexcept
+            {
+                return true;
+            }
+        };
+    }
+
+    /// lower_bound без ветвлений: на каждом шаге условный сдвиг базы (cmov),
+    /// а обе возможные следующие середины заранее подгружаются в кэш.
+    template <std::random_access_iterator Iterator, class Value, class Compare = std::less<>>
+    Iterator lower_bound(Iterator first, Iterator last, const Value& value, Compare compare = Compare())
+    {
+        auto length = last - first;
+        if (length == 0) {
+            return first;
+        }
+        auto base = first;
+        while (length > 1) {
+            const auto half = length / 2;
+            if constexpr (std::contiguous_iterator<Iterator>) {
+                details::prefetch(std::to_address(base + half / 2));
+                details::prefetch(std::to_address(base + half + half / 2));
+            }
+            base = compare(base[half - 1], value) ? base + half : base;
+            length -= half;
+        }
+        return base + (compare(*base, value) ? 1 : 0);
+    }
+
+    template <std::random_access_iterator Iterator, class Value>
+    Iterator find(Iterator first, Iterator last, const Value& value)
+    {
+        auto it = lib::lower_bound(first, last, value);
+        if (it != last && *it == value) {
+            return it;
+        }
+        return last;
+    }
+
+    /// Отсортированный массив в порядке обхода в ширину (раскладка Эйтцингера):
+    /// первые уровни дерева поиска лежат в нескольких кэш-линиях, а потомки
+    /// узла через несколько уровней - в одной линии, которую можно подгрузить заранее.
+    template <class T, class Compare = std::less<>>
+    class EytzingerArray
+    {
+        /// ключей в кэш-линии: потомки узла k через log2(block) уровней начинаются с k * block
+        constexpr static inline std::size_t block = std::max<std::size_t>(1, details::cache_line / sizeof(T));
+
+        std::vector<T, details::CacheLineAllocator<T>> keys;   // keys[0] не используется
+        std::vector<std::uint32_t> ranks;                      // позиция ключа в отсортированном порядке
+        [[no_unique_address]] Compare compare;
+    public:
+        EytzingerArray()
+        : keys(1)
+        , ranks(1, 0)
+        {}
+
+        /// range должен быть отсортирован по compare.
+        template <std::ranges::input_range Range>
+        explicit EytzingerArray(const Range& range, Compare compare = Compare())
+        : compare(compare)
+        {
+            std::vector<T> sorted(std::ranges::begin(range), std::ranges::end(range));
+            keys.resize(sorted.size() + 1);
+            ranks.resize(sorted.size() + 1, static_cast<std::uint32_t>(sorted.size()));
+            std::size_t position = 0;
+            build(sorted, position, 1);
+        }
+    public:
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return keys.size() - 1;
+        }
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        /// Позиция первого ключа не меньше value в исходном отсортированном диапазоне или size().
+        template <class Value>
+        [[nodiscard]] std::size_t lower_bound(const Value& value) const noexcept
+        {
+            return ranks[search(value)];
+        }
+        template <class Value>
+        [[nodiscard]] bool contains(const Value& value) const noexcept
+        {
+            const auto k = search(value);
+            return k != 0 && !compare(value, keys[k]);
+        }
+    private:
+        template <class Value>
+        std::size_t search(const Value& value) const noexcept
+        {
+            const auto n = size();
+            std::size_t k = 1;
+            while (k <= n) {
+                details::prefetch(keys.data() + std::min(k * block, n));
+                k = 2 * k + (compare(keys[k], value) ? 1 : 0);
+            }
+            // снимаем хвост правых поворотов и последний левый
+            return k >> (std::countr_one(k) + 1);
+        }
+
+        void build(const std::vector<T>& sorted, std::size_t& position, std::size_t k)
+        {
+            // симметричный обход дерева с явным стеком
+            std::vector<std::size_t> stack;
+            while (k < keys.size() || !stack.empty()) {
+                while (k < keys.size()) {
+                    stack.push_back(k);
+                    k = 2 * k;
+                }
+                k = stack.back();
+                stack.pop_back();
+                keys[k] = sorted[position];
+                ranks[k] = static_cast<std::uint32_t>(position);
+                position += 1;
+                k = 2 * k + 1;
+            }
+        }
+    };
+
+    /// Статическое B-дерево для 32-битных целых ключей: узел - 16 ключей в одной
+    /// кэш-линии, место в узле находится SIMD-сравнением всех ключей сразу,
+    /// поэтому на запрос приходится log17(n) промахов кэша вместо log2(n).
+    template <class T>
+    requires (std::is_integral_v<T> && sizeof(T) == 4)
+    class KAryTree
+    {
+        constexpr static inline std::size_t keys_per_node = 16;
+
+        struct alignas(details::cache_line) Node
+        {
+            std::int32_t keys[keys_per_node];
+        };
+
+        std::vector<Node, details::CacheLineAllocator<Node>> nodes;
+        std::vector<std::uint32_t> ranks;
+        std::size_t count = 0;
+    public:
+        KAryTree()
+        : ranks(1, 0)
+        {}
+
+        /// range должен быть отсортирован по возрастанию.
+        template <std::ranges::input_range Range>
+        explicit KAryTree(const Range& range)
+        {
+            std::vector<T> sorted(std::ranges::begin(range), std::ranges::end(range));
+            count = sorted.size();
+            nodes.resize((count + keys_per_node - 1) / keys_per_node);
+            ranks.resize(nodes.size() * keys_per_node + 1, static_cast<std::uint32_t>(count));
+            std::size_t position = 0;
+            build(sorted, position, 0);
+        }
+    public:
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return count;
+        }
+
+        /// Позиция первого ключа не меньше value в исходном отсортированном диапазоне или size().
+        [[nodiscard]] std::size_t lower_bound(T value) const noexcept
+        {
+            return ranks[search(bias(value))];
+        }
+        [[nodiscard]] bool contains(T value) const noexcept
+        {
+            const auto key = bias(value);
+            const auto slot = search(key);
+            return ranks[slot] < count && nodes[slot / keys_per_node].keys[slot % keys_per_node] == key;
+        }
+    private:
+        /// Номер ячейки с первым ключом не меньше key; последний элемент ranks - "нет такого".
+        std::size_t search(std::int32_t key) const noexcept
+        {
+            std::size_t result = ranks.size() - 1;
+            std::size_t k = 0;
+            while (k < nodes.size()) {
+                const auto index = rank_in_node(nodes[k], key);
+                if (index < keys_per_node) {
+                    result = k * keys_per_node + index;
+                }
+                k = child(k, index);
+            }
+            return result;
+        }
+
+        constexpr static std::size_t child(std::size_t k, std::size_t index) noexcept
+        {
+            return k * (keys_per_node + 1) + index + 1;
+        }
+
+        /// Беззнаковые ключи сдвигаются в знаковый диапазон: SSE2 сравнивает только со знаком.
+        constexpr static std::int32_t bias(T value) noexcept
+        {
+            if constexpr (std::is_signed_v<T>) {
+                return static_cast<std::int32_t>(value);
+            } else {
+                return static_cast<std::int32_t>(static_cast<std::uint32_t>(value) ^ 0x80000000U);
+            }
+        }
+
+        /// Число ключей узла меньше key.
+        static std::size_t rank_in_node(const Node& node, std::int32_t key) noexcept
+        {
+#if LIB_BINARY_SEARCH_SSE2
+            const __m128i pattern = _mm_set1_epi32(key);
+            const auto* keys = reinterpret_cast<const __m128i*>(node.keys);
+            const auto lt0 = _mm_cmpgt_epi32(pattern, _mm_load_si128(keys + 0));
+            const auto lt1 = _mm_cmpgt_epi32(pattern, _mm_load_si128(keys + 1));
+            const auto lt2 = _mm_cmpgt_epi32(pattern, _mm_load_si128(keys + 2));
+            const auto lt3 = _mm_cmpgt_epi32(pattern, _mm_load_si128(keys + 3));
+            const auto packed = _mm_packs_epi16(_mm_packs_epi32(lt0, lt1), _mm_packs_epi32(lt2, lt3));
+            return static_cast<std::size_t>(std::popcount(static_cast<std::uint32_t>(_mm_movemask_epi8(packed))));
+#else
+            std::size_t result = 0;
+            for (auto current: node.keys) {
+                result += current < key ? 1 : 0;
+            }
+            return result;
+#endif
+        }
+
+        void build(const std::vector<T>& sorted, std::size_t& position, std::size_t k)
+        {
+            if (k >= nodes.size()) {
+                return;
+            }
+            for (std::size_t i = 0; i < keys_per_node; ++i) {
+                build(sorted, position, child(k, i));
+                if (position < sorted.size()) {
+                    nodes[k].keys[i] = bias(sorted[position]);
+                    ranks[k * keys_per_node + i] = static_cast<std::uint32_t>(position);
+                    position += 1;
+                } else {
+                    nodes[k].keys[i] = std::numeric_limits<std::int32_t>::max();
+                }
+            }
+            build(sorted, position, child(k, keys_per_node));
+        }
+    };
+
+    unittest {
+        const int values[] = {1, 3, 3, 5, 8, 13, 21};
+        check(lib::lower_bound(std::begin(values), std::end(values), 0) == values);
+        check(lib::lower_bound(std::begin(values), std::end(values), 3) == values + 1);
+        check(lib::lower_bound(std::begin(values), std::end(values), 4) == values + 3);
+        check(lib::lower_bound(std::begin(values), std::end(values), 22) == std::end(values));
+        check(lib::find(std::begin(values), std::end(values), 13) == values + 5);
+        check(lib::find(std::begin(values), std::end(values), 14) == std::end(values));
+    }
+
+    unittest {
+        std::vector<int> sorted;
+        for (int i = 0; i < 1000; ++i) {
+            sorted.push_back(i * 3);
+        }
+        const EytzingerArray<int> eytzinger(sorted);
+        const KAryTree<int> kary(sorted);
+        check(eytzinger.size() == 1000 && kary.size() == 1000);
+
+        bool same = true;
+        for (int value = -5; value < 3010; ++value) {
+            const auto expected = static_cast<std::size_t>(std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin());
+            same = same && eytzinger.lower_bound(value) == expected;
+            same = same && kary.lower_bound(value) == expected;
+            same = same && eytzinger.contains(value) == (value >= 0 && value < 3000 && value % 3 == 0);
+        }
+        check(same);
+        check(kary.contains(999) && !kary.contains(1000));
+
+        const std::vector<std::uint32_t> big = {1, 0x7FFFFFFFU, 0x80000000U, 0xFFFFFFF0U};
+        const KAryTree<std::uint32_t> unsigned_keys(big);
+        check(unsigned_keys.lower_bound(0x80000000U) == 2);
+        check(unsigned_keys.lower_bound(0xFFFFFFFFU) == 4);
+        check(unsigned_keys.lower_bound(0) == 0);
+
+        const EytzingerArray<int> empty(std::vector<int>{});
+        check(empty.lower_bound(1) == 0 && !empty.contains(1));
+        check(EytzingerArray<int>().empty() && KAryTree<int>().lower_bound(1) == 0);
+    }
+}
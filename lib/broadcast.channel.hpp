@@ -1,72 +1,111 @@
 #pragma once
 #if false
 #include <array>
-#include <lib/buffered.channel.hpp>
-#include <lib/mutex.hpp>
+#include <lib/channel.hpp>
+#include <lib/lockfree/broadcast.ring.hpp>
 
 namespace lib {
-    template <class T, class ...Channels>
-    class BroadCastChannel: public OChannel<BroadCastChannel<T, Channels...>>
+    using lockfree::BroadcastGating;
+
+    /// Широковещательный канал: сообщение хранится в кольце один раз,
+    /// каждый BroadcastChannel::Reader читает его по своему курсору.
+    template <class T, std::size_t N, BroadcastGating Gating = BroadcastGating::Block, std::size_t MaxReaders = 32>
+    class BroadcastChannel: public OChannel<BroadcastChannel<T, N, Gating, MaxReaders>>
     {
+        using Ring = lockfree::BroadcastRing<T, N, Gating, MaxReaders>;
+
+        mutable Ring ring;
+        std::atomic_bool closed_ = false;
+        mutable Event oevent;
+        /// последнее событие - для читателей, которым не хватило курсора
+        mutable std::array<Event, MaxReaders + 1> ievents;
     public:
         using Type = T;
-        using SEvent = EventMux<typename Channels::SEvent& ...>;
-    private:
-        std::tuple<Channels&...> channels;
-        mutable SEvent events;
-    public:
-        BroadCastChannel(Channels& ...channels) noexcept
-        : channels{channels...}
-        , events(channels.sevent()...)
-        {}
+        using SEvent = Event;
+
+        class Reader: public IChannelBase<Reader>
+        {
+            BroadcastChannel& channel;
+            typename Ring::Reader reader;
+        public:
+            using Type = const T&;
+            using Event = lib::Event;
+        public:
+            explicit Reader(BroadcastChannel& channel) noexcept
+            : channel(channel)
+            , reader(channel.ring)
+            {}
+        public:
+            std::size_t poll() const noexcept
+            {
+                return reader.poll();
+            }
+            const T& peek() const noexcept
+            {
+                return reader.peek();
+            }
+            void next() noexcept
+            {
+                reader.next();
+                channel.oevent.emit();
+            }
+            Event& event() const noexcept
+            {
+                return channel.ievents[reader.index()];
+            }
+            bool closed() const noexcept
+            {
+                return channel.closed() || reader.detached();
+            }
+            void close() noexcept
+            {
+                channel.close();
+            }
+            std::size_t lost() const noexcept
+            {
+                return reader.lost();
+            }
+        };
     public:
         SEvent& sevent() const noexcept
         {
-            return events;
-        }
-        void usend(T value)
-        {
-            usend(std::move(value), std::make_index_sequence<sizeof...(Channels)>{});
+            return oevent;
         }
         bool spoll() const noexcept
         {
-            return spoll(std::make_index_sequence<sizeof...(Channels)>{});
+            return !closed() && ring.reserve();
         }
-        void close() noexcept
+        void usend(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
         {
-            close(std::make_index_sequence<sizeof...(Channels)>{});
+            ring.publish(std::move(value));
+            notify();
         }
+    public:
         bool closed() const noexcept
         {
-            return closed(std::make_index_sequence<sizeof...(Channels)>{});
+            return closed_;
         }
-    private:
-        template <std::size_t ...I>
-        bool spoll(std::index_sequence<I...>) const noexcept
+        void close() noexcept
         {
-            return (std::get<I>(channels).spoll() && ...);
+            closed_ = true;
+            for (auto& event: ievents) {
+                event.emit();
+            }
+            oevent.emit();
         }
-
-        template <std::size_t ...I>
-        void usend(T value, std::index_sequence<I...>)
+        Reader reader() noexcept
         {
-            (std::get<I>(channels).usend(value), ...);
+            return Reader(*this);
         }
-
-        template <std::size_t ...I>
-        unsigned closed(std::index_sequence<I...>) const noexcept
-        {
-            return (std::get<I>(channels).closed() || ...);
-        }
-
-        template <std::size_t ...I>
-        void close(std::index_sequence<I...>) noexcept
+    private:
+        void notify() const noexcept
         {
-            (std::get<I>(channels).close(), ...);
+            for (std::size_t i = 0; i < MaxReaders; ++i) {
+                if (ring.active(i)) {
+                    ievents[i].emit();
+                }
+            }
         }
     };
-
-    template <class ...Channels>
-    BroadCastChannel(Channels& ...channels) -> BroadCastChannel<std::common_type_t<typename Channels::Type ...>, Channels...>;
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,257 @@
+#pragma once
+#include <lib/buffer.hpp>
+#include <lib/array.hpp>
+#include <lib/platform.hpp>
+#include <lib/raw.storage.hpp>
+#include <lib/test.hpp>
+#include <array>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#if LIB_PLATFORM == LIB_PLATFORM_LINUX
+#   include <sys/uio.h>
+#endif
+
+namespace lib::buffer {
+
+    /// Последовательность сегментов Owner<T>, которая ведёт себя как один буфер:
+    /// сообщение из нескольких принятых блоков собирается без копирования.
+    /// До N сегментов хранятся внутри объекта, дальше - в куче.
+    template <class T, std::size_t N = 4>
+    class Chain
+    {
+        using Segment = Owner<T>;
+
+        std::array<RawStorage<Segment>, N> local;
+        Segment*    segments = local[0].ptr();
+        std::size_t count    = 0;
+        std::size_t capacity = N;
+        std::size_t length   = 0;
+
+    public:
+        Chain() noexcept = default;
+        Chain(const Chain&) = delete;
+        Chain& operator=(const Chain&) = delete;
+        Chain(Chain&& other) noexcept
+        {
+            steal(other);
+        }
+        Chain& operator=(Chain&& other) noexcept
+        {
+            if (this != &other) {
+                clear();
+                release();
+                steal(other);
+            }
+            return *this;
+        }
+        ~Chain() noexcept
+        {
+            clear();
+            release();
+        }
+
+    public:
+        /// Число элементов во всех сегментах.
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return length;
+        }
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return length == 0;
+        }
+        [[nodiscard]] std::size_t segments_count() const noexcept
+        {
+            return count;
+        }
+        [[nodiscard]] const Segment* begin() const noexcept
+        {
+            return segments;
+        }
+        [[nodiscard]] const Segment* end() const noexcept
+        {
+            return segments + count;
+        }
+
+        void append(Segment segment)
+        {
+            if (segment.empty()) {
+                return;
+            }
+            if (count == capacity) {
+                grow(capacity * 2);
+            }
+            length += segment.size();
+            new (&segments[count++]) Segment(std::move(segment));
+        }
+
+        void append(Chain&& other)
+        {
+            for (std::size_t i = 0; i < other.count; ++i) {
+                append(std::move(other.segments[i]));
+            }
+            other.clear();
+        }
+
+        /// Отделяет первые offset элементов: они возвращаются, в *this остаётся хвост.
+        /// Сегмент на границе делится без копирования данных.
+        Chain split(std::size_t offset)
+        {
+            Chain head;
+            offset = std::min(offset, length);
+            std::size_t taken = 0;
+            while (taken < count && offset >= segments[taken].size()) {
+                offset -= segments[taken].size();
+                head.append(std::move(segments[taken]));
+                taken += 1;
+            }
+            if (taken < count && offset != 0) {
+                auto& segment = segments[taken];
+                head.append(segment.split(0, offset));
+                segment = Segment(segment.split(offset, segment.size()));
+            }
+            if (taken != 0) {
+                for (std::size_t i = 0; i < taken; ++i) {
+                    std::destroy_at(&segments[i]);
+                }
+                for (std::size_t i = taken; i < count; ++i) {
+                    new (&segments[i - taken]) Segment(std::move(segments[i]));
+                    std::destroy_at(&segments[i]);
+                }
+                count -= taken;
+            }
+            length -= head.length;
+            return head;
+        }
+
+        /// Копирует до out.size() элементов, начиная с offset.
+        std::size_t copy(ViewImpl<std::remove_const_t<T>> out, std::size_t offset = 0) const noexcept
+        {
+            std::size_t copied = 0;
+            for (const auto& segment: *this) {
+                if (copied == out.size()) {
+                    break;
+                }
+                if (offset >= segment.size()) {
+                    offset -= segment.size();
+                    continue;
+                }
+                const auto size = std::min(segment.size() - offset, out.size() - copied);
+                std::copy_n(segment.data() + offset, size, out.data() + copied);
+                copied += size;
+                offset = 0;
+            }
+            return copied;
+        }
+
+#if LIB_PLATFORM == LIB_PLATFORM_LINUX
+        /// Заполняет out для readv/writev, возвращает число заполненных iovec.
+        std::size_t export_iovec(Span<::iovec> out) const noexcept
+        {
+            const auto size = std::min(out.size(), count);
+            for (std::size_t i = 0; i < size; ++i) {
+                out[i].iov_base = const_cast<std::remove_const_t<T>*>(segments[i].data());
+                out[i].iov_len  = segments[i].size() * sizeof(T);
+            }
+            return size;
+        }
+#endif
+
+        void clear() noexcept
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                std::destroy_at(&segments[i]);
+            }
+            count = 0;
+            length = 0;
+        }
+
+    private:
+        [[nodiscard]] bool is_local() const noexcept
+        {
+            return segments == local[0].ptr();
+        }
+
+        void grow(std::size_t size)
+        {
+            auto* grown = static_cast<Segment*>(::operator new(size * sizeof(Segment)));
+            for (std::size_t i = 0; i < count; ++i) {
+                new (&grown[i]) Segment(std::move(segments[i]));
+                std::destroy_at(&segments[i]);
+            }
+            release();
+            segments = grown;
+            capacity = size;
+        }
+
+        void release() noexcept
+        {
+            if (!is_local()) {
+                ::operator delete(segments);
+            }
+            segments = local[0].ptr();
+            capacity = N;
+        }
+
+        void steal(Chain& other) noexcept
+        {
+            length = std::exchange(other.length, 0);
+            if (other.is_local()) {
+                segments = local[0].ptr();
+                capacity = N;
+                count = other.count;
+                for (std::size_t i = 0; i < count; ++i) {
+                    new (&segments[i]) Segment(std::move(other.segments[i]));
+                    std::destroy_at(&other.segments[i]);
+                }
+                other.count = 0;
+            } else {
+                segments = std::exchange(other.segments, other.local[0].ptr());
+                capacity = std::exchange(other.capacity, N);
+                count = std::exchange(other.count, 0);
+            }
+        }
+    };
+
+    unittest {
+        Chain<char, 2> chain;
+        chain.append(Owner<char>(std::string("hello ")));
+        chain.append(Owner<char>(std::string("")));
+        chain.append(Owner<char>(std::string("wonderful ")));
+        chain.append(Owner<char>(std::string("world")));
+        check(chain.size() == 21 && chain.segments_count() == 3);
+
+        auto head = chain.split(8);
+        check(head.size() == 8 && head.segments_count() == 2);
+        check(chain.size() == 13 && chain.segments_count() == 2);
+
+        std::array<char, 21> text {};
+        check(head.copy(ViewImpl<char>(text.data(), text.size())) == 8);
+        check(chain.copy(ViewImpl<char>(text.data() + 8, text.size() - 8)) == 13);
+        check(std::string_view(text.data(), text.size()) == "hello wonderful world");
+
+        auto tail = chain.split(100);
+        check(chain.empty() && tail.size() == 13);
+        head.append(std::move(tail));
+        check(head.size() == 21 && head.segments_count() == 4);
+
+        Chain<char, 2> moved(std::move(head));
+        check(moved.size() == 21 && head.empty());
+#if LIB_PLATFORM == LIB_PLATFORM_LINUX
+        std::array<::iovec, 8> iov {};
+        check(moved.export_iovec(Span<::iovec>(iov.data(), iov.size())) == 4);
+        check(iov[0].iov_len == 6 && iov[1].iov_len == 2 && iov[2].iov_len == 8 && iov[3].iov_len == 5);
+#endif
+    }
+
+    unittest {
+        // разрез внутри первого сегмента оставляет хвост на месте
+        Chain<const char> chain;
+        chain.append(Owner<const char>("hello world"));
+        auto head = chain.split(5);
+        check(head.size() == 5 && chain.size() == 6 && chain.segments_count() == 1);
+        check(chain.begin()->size() == 6 && chain.begin()->data()[0] == ' ');
+    }
+}
@@ -1,11 +1,18 @@
 #pragma once
+#include <lib/lockfree/block.pool.hpp>
+#include <lib/buffer.simd.hpp>
+#include <lib/test.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <array>
 #include <cstddef>
 #include <cstdlib>
 #include <type_traits>
 #include <string_view>
+#include <utility>
 
 namespace lib::buffer {
 
@@ -97,32 +104,121 @@ namespace lib::buffer {
         {
             return *this;
         }
+    public:
+        constexpr static inline std::size_t npos = simd::npos;
+
+        /// Индекс первого value, начиная с from, или npos. Для байтовых типов - SIMD.
+        [[nodiscard]] std::size_t find(const std::remove_cv_t<T>& value, std::size_t from = 0) const noexcept
+        {
+            if (from >= size_) {
+                return npos;
+            }
+            if constexpr (bytewise) {
+                const auto index = simd::find(data_ + from, size_ - from, static_cast<std::byte>(value));
+                return index == npos ? npos : from + index;
+            } else {
+                const auto found = std::find(data_ + from, data_ + size_, value);
+                return found == end() ? npos : static_cast<std::size_t>(found - data_);
+            }
+        }
+        /// Индекс первого вхождения разделителя, начиная с from, или npos.
+        [[nodiscard]] std::size_t find(ViewImpl<const T> delimiter, std::size_t from = 0) const noexcept
+        {
+            if (from > size_) {
+                return npos;
+            }
+            if constexpr (bytewise) {
+                const auto index = simd::search(data_ + from, size_ - from, delimiter.data(), delimiter.size());
+                return index == npos ? npos : from + index;
+            } else {
+                const auto found = std::search(data_ + from, data_ + size_, delimiter.begin(), delimiter.end());
+                return found == end() && !delimiter.empty() ? npos : static_cast<std::size_t>(found - data_);
+            }
+        }
     public:
         friend bool operator==(const ViewImpl& a, const ViewImpl& b) noexcept
         {
-            return std::equal(a.begin(), a.end(), b.begin(), b.end());
+            if constexpr (bytewise) {
+                return a.size_ == b.size_ && simd::equal(a.data_, b.data_, a.size_);
+            } else {
+                return std::equal(a.begin(), a.end(), b.begin(), b.end());
+            }
         }
         friend bool operator!=(const ViewImpl& a, const ViewImpl& b) noexcept
         {
-            return !std::equal(a.begin(), a.end(), b.begin(), b.end());
+            return !(a == b);
         }
+    private:
+        constexpr static inline bool bytewise = sizeof(T) == 1
+            && (std::is_integral_v<T> || std::is_same_v<std::remove_cv_t<T>, std::byte>);
     };
 
     template <class T>
     class Owner;
 
+    /// Подсчёт ссылок на Resource: Local - без атомарных операций,
+    /// если все Owner одного ресурса живут в одном потоке.
+    enum class RefCount: bool
+    {
+        Local,
+        Atomic,
+    };
+
     template <class T>
     struct Resource: Resource<const T>
     {
+        using Resource<const T>::Resource;
         using Resource<const T>::data;
         virtual T* data() noexcept = 0;
     };
 
+    /// Счётчик ссылок хранится в самом ресурсе, новый ресурс имеет одну ссылку.
     template <class T>
     struct Resource<const T>
     {
+        explicit Resource(RefCount mode = RefCount::Atomic) noexcept
+        : mode(mode)
+        {}
+        Resource(const Resource&) = delete;
+        Resource& operator=(const Resource&) = delete;
+
         [[nodiscard]] virtual const T* data() const noexcept = 0;
         [[nodiscard]] virtual std::size_t size() const noexcept = 0;
+
+        void acquire() const noexcept
+        {
+            if(mode == RefCount::Atomic) {
+                refs.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                refs.store(refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+        void release() const noexcept
+        {
+            std::uint32_t last = 0;
+            if(mode == RefCount::Atomic) {
+                last = refs.fetch_sub(1, std::memory_order_acq_rel);
+            } else {
+                last = refs.load(std::memory_order_relaxed);
+                refs.store(last - 1, std::memory_order_relaxed);
+            }
+            if(last == 1) {
+                const_cast<Resource*>(this)->destroy();
+            }
+        }
+        [[nodiscard]] bool unique() const noexcept
+        {
+            return refs.load(std::memory_order_acquire) == 1;
+        }
+    protected:
+        virtual ~Resource() = default;
+        virtual void destroy() noexcept
+        {
+            delete this;
+        }
+    private:
+        mutable std::atomic<std::uint32_t> refs {1};
+        RefCount mode;
     };
 
     template <class T, class Container>
@@ -141,8 +237,9 @@ namespace lib::buffer {
         {
             return container.size();
         }
-        constexpr ContainerResource(Container&& container) noexcept
-        : container(std::move(container))
+        ContainerResource(Container&& container, RefCount mode) noexcept
+        : Resource<T>(mode)
+        , container(std::move(container))
         {}
     };
 
@@ -158,8 +255,9 @@ namespace lib::buffer {
         {
             return container.size();
         }
-        constexpr ContainerResource(Container&& container) noexcept
-        : container(std::move(container))
+        ContainerResource(Container&& container, RefCount mode) noexcept
+        : Resource<const T>(mode)
+        , container(std::move(container))
         {}
     };
 
@@ -168,31 +266,41 @@ namespace lib::buffer {
     {
         template <class U>
         friend class Owner;
+        template <class U>
+        friend class Fill;
         using Base = ViewImpl<T>;
     protected:
+        Resource<T>* resource = nullptr;
 
-        std::shared_ptr<Resource<T>> resource = nullptr;
+        /// Новая ссылка на resource для share()/split().
+        Resource<T>* acquire() const noexcept
+        {
+            if(resource != nullptr) {
+                resource->acquire();
+            }
+            return resource;
+        }
     public:
         using Type = T;
     public:
         constexpr OwnerImpl(T* data, std::size_t size) noexcept
         : Base(data, size)
         {}
-        template <class R>
-        OwnerImpl(std::shared_ptr<R> resource) noexcept
-        : Base(resource->data(), resource->size())
-        , resource(std::move(resource))
+        /// Забирает уже учтённую ссылку на resource.
+        explicit OwnerImpl(Resource<T>* resource) noexcept
+        : Base(resource != nullptr ? resource->data() : nullptr, resource != nullptr ? resource->size() : 0)
+        , resource(resource)
         {}
 
-        template <class R>
-        OwnerImpl(std::shared_ptr<R> resource, ViewImpl<T> view) noexcept
+        OwnerImpl(Resource<T>* resource, ViewImpl<T> view) noexcept
         : Base(view)
-        , resource(std::move(resource))
+        , resource(resource)
         {}
 
         template <class Container>
-        explicit OwnerImpl(Container&& c) // NOLINT
-        : OwnerImpl(std::make_shared<ContainerResource<T, std::decay_t<Container>>>(std::forward<Container>(c)))
+        requires (!std::is_pointer_v<std::decay_t<Container>>)
+        explicit OwnerImpl(Container&& c, RefCount mode = RefCount::Atomic) // NOLINT
+        : OwnerImpl(new ContainerResource<T, std::decay_t<Container>>(std::forward<Container>(c), mode))
         {}
 
         template <std::size_t Size>
@@ -203,27 +311,49 @@ namespace lib::buffer {
         OwnerImpl() = default;
         OwnerImpl(ViewImpl<T>) = delete;
         OwnerImpl(const OwnerImpl&) = delete;
-        OwnerImpl(OwnerImpl&&) = default;
+        OwnerImpl(OwnerImpl&& other) noexcept
+        : Base(other)
+        , resource(std::exchange(other.resource, nullptr))
+        {
+            static_cast<Base&>(other) = Base();
+        }
         OwnerImpl& operator=(const OwnerImpl&) = delete;
-        OwnerImpl& operator=(OwnerImpl&&) = default;
+        OwnerImpl& operator=(OwnerImpl&& other) noexcept
+        {
+            if(this != &other) {
+                if(resource != nullptr) {
+                    resource->release();
+                }
+                static_cast<Base&>(*this) = other;
+                static_cast<Base&>(other) = Base();
+                resource = std::exchange(other.resource, nullptr);
+            }
+            return *this;
+        }
+        ~OwnerImpl() noexcept
+        {
+            if(resource != nullptr) {
+                resource->release();
+            }
+        }
     public:
         [[nodiscard]] OwnerImpl share() const noexcept
         {
-            return resource;
+            return OwnerImpl(acquire(), *this);
         }
-        [[nodiscard]] constexpr OwnerImpl split(std::size_t first, std::size_t last) const noexcept
+        [[nodiscard]] OwnerImpl split(std::size_t first, std::size_t last) const noexcept
         {
-            return OwnerImpl(resource, ViewImpl<T>::split(first, last));
+            return OwnerImpl(acquire(), ViewImpl<T>::split(first, last));
         }
-        [[nodiscard]] constexpr OwnerImpl split(First, std::size_t last) const noexcept
+        [[nodiscard]] OwnerImpl split(First, std::size_t last) const noexcept
         {
             return split(0, last);
         }
-        [[nodiscard]] constexpr OwnerImpl split(std::size_t first, Last) const noexcept
+        [[nodiscard]] OwnerImpl split(std::size_t first, Last) const noexcept
         {
             return split(first, ViewImpl<T>::size() - 1U);
         }
-        [[nodiscard]] constexpr OwnerImpl split(First, Last) const noexcept
+        [[nodiscard]] OwnerImpl split(First, Last) const noexcept
         {
             return share();
         }
@@ -285,13 +415,16 @@ namespace lib::buffer {
     {
     public:
         using OwnerImpl<T>::OwnerImpl;
+        Owner(OwnerImpl<T>&& other) noexcept // NOLINT
+        : OwnerImpl<T>(std::move(other))
+        {}
         constexpr operator View<const T>() const noexcept
         {
             return View<const T>(OwnerImpl<T>::data(), OwnerImpl<T>::size());
         }
         [[nodiscard]] Owner share() const noexcept
         {
-            return OwnerImpl<T>::resource;
+            return Owner(OwnerImpl<T>::acquire(), *this);
         }
     };
 
@@ -300,6 +433,9 @@ namespace lib::buffer {
     {
     public:
         using OwnerImpl<const char>::OwnerImpl;
+        Owner(OwnerImpl<const char>&& other) noexcept // NOLINT
+        : OwnerImpl<const char>(std::move(other))
+        {}
         constexpr Owner(std::string_view view) noexcept
         : OwnerImpl<const char>(view.data(), view.size())
         {}
@@ -308,11 +444,11 @@ namespace lib::buffer {
         : OwnerImpl<const char>(value, Size - 1)
         {}
         Owner(Owner<char>&& other) noexcept
-        : OwnerImpl<const char>(std::move(other.resource), other)
+        : OwnerImpl<const char>(std::exchange(other.resource, nullptr), ViewImpl<const char>(other.data(), other.size()))
         {}
         [[nodiscard]] Owner share() const noexcept
         {
-            return OwnerImpl<const char>::resource;
+            return Owner(OwnerImpl<const char>::acquire(), *this);
         }
     };
 
@@ -321,12 +457,15 @@ namespace lib::buffer {
     {
     public:
         using OwnerImpl<const T>::OwnerImpl;
+        Owner(OwnerImpl<const T>&& other) noexcept // NOLINT
+        : OwnerImpl<const T>(std::move(other))
+        {}
         Owner(Owner<T>&& other) noexcept
-        : OwnerImpl<const T>(std::move(other.resource), other)
+        : OwnerImpl<const T>(std::exchange(other.resource, nullptr), ViewImpl<const T>(other.data(), other.size()))
         {}
         Owner share() const noexcept
         {
-            return OwnerImpl<const T>::resource;
+            return Owner(OwnerImpl<const T>::acquire(), *this);
         }
     };
 
@@ -354,13 +493,19 @@ namespace lib::buffer {
     template <class T>
     class Fill
     {
+        /// Блок возвращается в memory_resource, из которого выделен, когда умирает последний Owner.
         class Container: public Resource<T>
         {
             T* array;
             std::size_t count = 0;
+            std::size_t capacity;
+            std::pmr::memory_resource* memory;
         public:
-            Container(void* array) noexcept
-            : array(static_cast<T*>(array))
+            Container(void* array, std::size_t capacity, RefCount mode, std::pmr::memory_resource* memory) noexcept
+            : Resource<T>(mode)
+            , array(static_cast<T*>(array))
+            , capacity(capacity)
+            , memory(memory)
             {}
         public:
             T* data() noexcept override
@@ -375,51 +520,101 @@ namespace lib::buffer {
             {
                 return count;
             }
+            [[nodiscard]] std::size_t limit() const noexcept
+            {
+                return capacity;
+            }
             template <class ...TArgs>
             void put(TArgs&& ...args)
             {
                 new(&array[count++]) T(std::forward<TArgs>(args)...);
             }
-            ~Container() noexcept
+            T* tail() noexcept
+            {
+                return array + count;
+            }
+            void commit(std::size_t size) noexcept
+            {
+                count += size;
+            }
+            void clear() noexcept
             {
                 for(std::size_t i = 0; i < count; ++i) {
                     std::destroy_at(&array[i]);
                 }
+                count = 0;
             }
-        };
-        struct ContainerDeleter
-        {
-            void operator()(Container* container) const noexcept
+            ~Container() noexcept override
             {
-                if(container) {
-                    std::destroy_at(container);
-                    ::operator delete(container);
-                }
+                clear();
+            }
+        protected:
+            void destroy() noexcept override
+            {
+                const auto size = bytes(capacity);
+                auto* resource = memory;
+                std::destroy_at(this);
+                resource->deallocate(this, size, align);
             }
         };
-        std::shared_ptr<Container> container;
+        Container* container = nullptr;
         std::size_t capacity = 0;
+        RefCount mode = RefCount::Atomic;
+        std::pmr::memory_resource* memory = &lockfree::PoolResource::global();
     private:
-        static std::unique_ptr<Container, ContainerDeleter> create(std::size_t size)
+        constexpr static auto align = std::max(alignof(Container), alignof(T));
+
+        constexpr static std::size_t bytes(std::size_t size) noexcept
         {
-            constexpr auto align = std::max(alignof(Container), alignof(T));
-            const auto asize = sizeof(Container) + (align - alignof(Container)) + sizeof(T) * size;
-            if(auto *ptr = ::operator new(asize)) {
-                new(ptr) Container(static_cast<std::byte*>(ptr) + sizeof(Container) + align - alignof(Container));
-                return std::unique_ptr<Container, ContainerDeleter>(static_cast<Container*>(ptr), ContainerDeleter{});
-            }
-            throw std::bad_alloc();
+            return sizeof(Container) + (align - alignof(Container)) + sizeof(T) * size;
+        }
+        static Container* create(std::size_t size, RefCount mode, std::pmr::memory_resource* memory)
+        {
+            auto* ptr = memory->allocate(bytes(size), align);
+            return new(ptr) Container(static_cast<std::byte*>(ptr) + sizeof(Container) + align - alignof(Container), size, mode, memory);
+        }
+        Owner<T> release() noexcept
+        {
+            capacity = 0;
+            return Owner<T>(static_cast<Resource<T>*>(std::exchange(container, nullptr)));
         }
     public:
         Fill() = default;
-        Fill(std::size_t size)
-        : container(create(size))
+        Fill(std::size_t size, RefCount mode = RefCount::Atomic)
+        : Fill(size, &lockfree::PoolResource::global(), mode)
+        {}
+        /// Блоки выделяются из memory, например из Arena на время запроса.
+        Fill(std::size_t size, std::pmr::memory_resource* memory, RefCount mode = RefCount::Atomic)
+        : container(create(size, mode, memory))
         , capacity(size)
+        , mode(mode)
+        , memory(memory)
+        {}
+        Fill(Fill&& other) noexcept
+        : container(std::exchange(other.container, nullptr))
+        , capacity(std::exchange(other.capacity, 0))
+        , mode(other.mode)
+        , memory(other.memory)
         {}
+        Fill& operator=(Fill&& other) noexcept
+        {
+            if(this != &other) {
+                release();
+                container = std::exchange(other.container, nullptr);
+                capacity = std::exchange(other.capacity, 0);
+                mode = other.mode;
+                memory = other.memory;
+            }
+            return *this;
+        }
+        ~Fill() noexcept
+        {
+            release();
+        }
         Owner<T> reset(std::size_t size)
         {
-            Owner<T> result(std::move(container));
-            container = create(size);
+            auto result = release();
+            container = create(size, mode, memory);
             capacity = size;
             return result;
         }
@@ -440,6 +635,40 @@ namespace lib::buffer {
         {
             container->put(std::forward<TArgs>(args)...);
         }
+        /// Незаполненная часть блока: в неё пишут напрямую, затем вызывают commit().
+        [[nodiscard]] ViewImpl<T> space() noexcept requires std::is_trivial_v<T>
+        {
+            return container ? ViewImpl<T>(container->tail(), capacity - container->size()) : ViewImpl<T>();
+        }
+        void commit(std::size_t size) noexcept requires std::is_trivial_v<T>
+        {
+            container->commit(size);
+        }
+        /// Отдаёт блок, не выделяя новый: после take() Fill пуст до recycle().
+        Owner<T> take() noexcept
+        {
+            return release();
+        }
+        /// Забирает обратно блок, выданный take() или reset(), если на него больше
+        /// никто не ссылается. Содержимое блока уничтожается.
+        bool recycle(Owner<T>&& block) noexcept
+        {
+            auto*& resource = static_cast<OwnerImpl<T>&>(block).resource;
+            if(resource == nullptr || !resource->unique()) {
+                return false;
+            }
+            auto* reused = dynamic_cast<Container*>(resource);
+            if(reused == nullptr) {
+                return false;
+            }
+            resource = nullptr;
+            block = Owner<T>();
+            release();
+            reused->clear();
+            container = reused;
+            capacity = reused->limit();
+            return true;
+        }
     };
 
     template <class T>
@@ -482,4 +711,12 @@ namespace lib::buffer {
             return buffer.data()[index++];
         }
     };
+
+    unittest {
+        // пустые виды без данных сравниваются без обращения к памяти
+        const ViewImpl<const char> empty;
+        const ViewImpl<const char> text("abc", 3);
+        check(empty == ViewImpl<const char>());
+        check(!(empty == text) && text == ViewImpl<const char>("abc", 3));
+    }
 }
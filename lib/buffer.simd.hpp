@@ -0,0 +1,545 @@
+#pragma once
+#include <lib/test.hpp>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#   define LIB_SIMD_X86 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       include <intrin.h>
+#       define LIB_TARGET_SSSE3
+#       define LIB_TARGET_AVX2
+#   else
+#       define LIB_TARGET_SSSE3 __attribute__((target("ssse3")))
+#       define LIB_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#else
+#   define LIB_SIMD_X86 0
+#endif
+
+/// Поиск и сравнение байтовых буферов: SSE2 и AVX2 на x86, скалярный код
+/// на остальных платформах. Набор инструкций выбирается один раз при первом вызове.
+namespace lib::buffer::simd {
+
+    constexpr inline std::size_t npos = static_cast<std::size_t>(-1);
+
+    enum class Level: std::uint8_t
+    {
+        Scalar,
+        SSE2,
+        SSSE3,
+        AVX2,
+    };
+
+    /// Множество байтов для векторной классификации. Кроме битовой карты хранит
+    /// таблицы по полубайтам: байт входит в множество, если low[b & 15] & high[b >> 4] != 0.
+    /// Таблицы точны, пока старшие полубайты дают не больше 8 разных столбцов
+    /// младших - для любого ASCII-множества это так; иначе поиск идёт по карте.
+    class ByteSet
+    {
+        std::array<std::uint64_t, 4> bits{};
+        std::array<std::uint8_t, 16> lows{};
+        std::array<std::uint8_t, 16> highs{};
+        bool tables = true;
+    public:
+        constexpr ByteSet() noexcept = default;
+        constexpr explicit ByteSet(std::string_view values) noexcept
+        {
+            for (auto value: values) {
+                set(static_cast<std::uint8_t>(value));
+            }
+            build();
+        }
+        constexpr ByteSet(std::uint8_t from, std::uint8_t to) noexcept
+        {
+            insert(from, to);
+        }
+    public:
+        constexpr ByteSet& insert(std::uint8_t value) noexcept
+        {
+            set(value);
+            build();
+            return *this;
+        }
+        constexpr ByteSet& insert(std::uint8_t from, std::uint8_t to) noexcept
+        {
+            for (unsigned value = from; value <= to; ++value) {
+                set(static_cast<std::uint8_t>(value));
+            }
+            build();
+            return *this;
+        }
+        [[nodiscard]] constexpr bool contains(std::uint8_t value) const noexcept
+        {
+            return (bits[value >> 6U] >> (value & 63U) & 1U) != 0;
+        }
+        [[nodiscard]] constexpr ByteSet operator~() const noexcept
+        {
+            ByteSet result;
+            for (std::size_t i = 0; i < bits.size(); ++i) {
+                result.bits[i] = ~bits[i];
+            }
+            result.build();
+            return result;
+        }
+        [[nodiscard]] constexpr bool vectorizable() const noexcept
+        {
+            return tables;
+        }
+        [[nodiscard]] constexpr const std::array<std::uint8_t, 16>& low() const noexcept
+        {
+            return lows;
+        }
+        [[nodiscard]] constexpr const std::array<std::uint8_t, 16>& high() const noexcept
+        {
+            return highs;
+        }
+    private:
+        constexpr void set(std::uint8_t value) noexcept
+        {
+            bits[value >> 6U] |= std::uint64_t(1) << (value & 63U);
+        }
+        /// Старшие полубайты с одинаковым набором младших получают общий бит.
+        constexpr void build() noexcept
+        {
+            std::array<std::uint16_t, 16> columns{};
+            for (unsigned value = 0; value < 256; ++value) {
+                if (contains(static_cast<std::uint8_t>(value))) {
+                    columns[value >> 4U] |= static_cast<std::uint16_t>(1U << (value & 15U));
+                }
+            }
+            std::array<std::uint16_t, 8> groups{};
+            std::size_t count = 0;
+            lows = {};
+            highs = {};
+            tables = true;
+            for (std::size_t h = 0; h < columns.size(); ++h) {
+                if (columns[h] == 0) {
+                    continue;
+                }
+                std::size_t g = 0;
+                while (g < count && groups[g] != columns[h]) {
+                    ++g;
+                }
+                if (g == count) {
+                    if (count == groups.size()) {
+                        tables = false;
+                        return;
+                    }
+                    groups[count++] = columns[h];
+                    for (std::size_t l = 0; l < 16; ++l) {
+                        if ((columns[h] >> l & 1U) != 0) {
+                            lows[l] |= static_cast<std::uint8_t>(1U << g);
+                        }
+                    }
+                }
+                highs[h] = static_cast<std::uint8_t>(1U << g);
+            }
+        }
+    };
+
+    namespace details {
+        using Byte = unsigned char;
+
+        inline std::size_t find(const Byte* data, std::size_t size, Byte value, std::size_t i = 0) noexcept
+        {
+            for (; i < size; ++i) {
+                if (data[i] == value) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        inline bool equal(const Byte* a, const Byte* b, std::size_t size, std::size_t i = 0) noexcept
+        {
+            // memcmp с нулевыми указателями не определён даже при нулевой длине
+            return i == size || std::memcmp(a + i, b + i, size - i) == 0;
+        }
+
+        inline std::size_t search(const Byte* data, std::size_t size, const Byte* needle, std::size_t length, std::size_t i = 0) noexcept
+        {
+            for (; i + length <= size; ++i) {
+                if (data[i] == needle[0] && std::memcmp(data + i + 1, needle + 1, length - 1) == 0) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        /// Длина начала, в котором принадлежность множеству равна Member.
+        template <bool Member>
+        inline std::size_t span(const Byte* data, std::size_t size, const ByteSet& set, std::size_t i = 0) noexcept
+        {
+            while (i < size && set.contains(data[i]) == Member) {
+                ++i;
+            }
+            return i;
+        }
+
+#if LIB_SIMD_X86
+        inline std::size_t find_sse2(const Byte* data, std::size_t size, Byte value) noexcept
+        {
+            const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+            std::size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                if (const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern))) {
+                    return i + std::countr_zero(mask);
+                }
+            }
+            return find(data, size, value, i);
+        }
+
+        inline bool equal_sse2(const Byte* a, const Byte* b, std::size_t size) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) {
+                    return false;
+                }
+            }
+            return equal(a, b, size, i);
+        }
+
+        /// Кандидаты отбираются по совпадению первого и последнего байта образца.
+        inline std::size_t search_sse2(const Byte* data, std::size_t size, const Byte* needle, std::size_t length) noexcept
+        {
+            const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+            const __m128i last  = _mm_set1_epi8(static_cast<char>(needle[length - 1]));
+            std::size_t i = 0;
+            for (; i + length - 1 + 16 <= size; i += 16) {
+                const auto head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                const auto tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1));
+                unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+                while (mask != 0) {
+                    const auto offset = i + std::countr_zero(mask);
+                    if (std::memcmp(data + offset + 1, needle + 1, length - 2) == 0) {
+                        return offset;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+            return search(data, size, needle, length, i);
+        }
+
+        template <bool Member>
+        LIB_TARGET_SSSE3 inline std::size_t span_ssse3(const Byte* data, std::size_t size, const ByteSet& set) noexcept
+        {
+            const __m128i lows  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low().data()));
+            const __m128i highs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high().data()));
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            std::size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                const auto lo = _mm_shuffle_epi8(lows, _mm_and_si128(block, nibble));
+                const auto hi = _mm_shuffle_epi8(highs, _mm_and_si128(_mm_srli_epi16(block, 4), nibble));
+                const auto outside = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())));
+                if (const unsigned stop = Member ? outside : outside ^ 0xFFFFU) {
+                    return i + std::countr_zero(stop);
+                }
+            }
+            return span<Member>(data, size, set, i);
+        }
+
+        LIB_TARGET_AVX2 inline std::size_t find_avx2(const Byte* data, std::size_t size, Byte value) noexcept
+        {
+            const __m256i pattern = _mm256_set1_epi8(static_cast<char>(value));
+            std::size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                if (const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern)))) {
+                    return i + std::countr_zero(mask);
+                }
+            }
+            return find(data, size, value, i);
+        }
+
+        LIB_TARGET_AVX2 inline bool equal_avx2(const Byte* a, const Byte* b, std::size_t size) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                if (static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y))) != 0xFFFFFFFFU) {
+                    return false;
+                }
+            }
+            return equal(a, b, size, i);
+        }
+
+        LIB_TARGET_AVX2 inline std::size_t search_avx2(const Byte* data, std::size_t size, const Byte* needle, std::size_t length) noexcept
+        {
+            const __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+            const __m256i last  = _mm256_set1_epi8(static_cast<char>(needle[length - 1]));
+            std::size_t i = 0;
+            for (; i + length - 1 + 32 <= size; i += 32) {
+                const auto head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                const auto tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + length - 1));
+                auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))));
+                while (mask != 0) {
+                    const auto offset = i + std::countr_zero(mask);
+                    if (std::memcmp(data + offset + 1, needle + 1, length - 2) == 0) {
+                        return offset;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+            return search(data, size, needle, length, i);
+        }
+
+        template <bool Member>
+        LIB_TARGET_AVX2 inline std::size_t span_avx2(const Byte* data, std::size_t size, const ByteSet& set) noexcept
+        {
+            const __m256i lows  = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low().data())));
+            const __m256i highs = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high().data())));
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            std::size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                const auto lo = _mm256_shuffle_epi8(lows, _mm256_and_si256(block, nibble));
+                const auto hi = _mm256_shuffle_epi8(highs, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+                const auto outside = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())));
+                if (const std::uint32_t stop = Member ? outside : ~outside) {
+                    return i + std::countr_zero(stop);
+                }
+            }
+            return span<Member>(data, size, set, i);
+        }
+
+        inline Level detect() noexcept
+        {
+#   if defined(_MSC_VER) && !defined(__clang__)
+            int info[4] = {};
+            __cpuid(info, 0);
+            const int ids = info[0];
+            if (ids >= 7) {
+                __cpuidex(info, 7, 0);
+                if ((info[1] & (1 << 5)) != 0) {
+                    return Level::AVX2;
+                }
+            }
+            __cpuid(info, 1);
+            if ((info[2] & (1 << 9)) != 0) {
+                return Level::SSSE3;
+            }
+            return Level::SSE2;
+#   else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return Level::AVX2;
+            }
+            if (__builtin_cpu_supports("ssse3")) {
+                return Level::SSSE3;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return Level::SSE2;
+            }
+            return Level::Scalar;
+#   endif
+        }
+#else
+        inline Level detect() noexcept
+        {
+            return Level::Scalar;
+        }
+#endif
+    }
+
+    /// Лучший набор инструкций, доступный на этом процессоре.
+    inline Level level() noexcept
+    {
+        static const Level level = details::detect();
+        return level;
+    }
+
+    /// Индекс первого байта value или npos.
+    inline std::size_t find(const void* data, std::size_t size, std::byte value, Level use = level()) noexcept
+    {
+        const auto* bytes = static_cast<const details::Byte*>(data);
+        const auto byte = static_cast<details::Byte>(value);
+        switch (use) {
+#if LIB_SIMD_X86
+        case Level::AVX2:  return details::find_avx2(bytes, size, byte);
+        case Level::SSSE3:
+        case Level::SSE2:  return details::find_sse2(bytes, size, byte);
+#endif
+        default:           return details::find(bytes, size, byte);
+        }
+    }
+
+    inline bool equal(const void* a, const void* b, std::size_t size, Level use = level()) noexcept
+    {
+        const auto* x = static_cast<const details::Byte*>(a);
+        const auto* y = static_cast<const details::Byte*>(b);
+        switch (use) {
+#if LIB_SIMD_X86
+        case Level::AVX2:  return details::equal_avx2(x, y, size);
+        case Level::SSSE3:
+        case Level::SSE2:  return details::equal_sse2(x, y, size);
+#endif
+        default:           return details::equal(x, y, size);
+        }
+    }
+
+    /// Индекс первого вхождения needle или npos; пустой образец находится в позиции 0.
+    inline std::size_t search(const void* data, std::size_t size, const void* needle, std::size_t length, Level use = level()) noexcept
+    {
+        const auto* bytes = static_cast<const details::Byte*>(data);
+        const auto* pattern = static_cast<const details::Byte*>(needle);
+        if (length == 0) {
+            return 0;
+        }
+        if (length > size) {
+            return npos;
+        }
+        if (length == 1) {
+            return find(data, size, std::byte(pattern[0]), use);
+        }
+        switch (use) {
+#if LIB_SIMD_X86
+        case Level::AVX2:  return details::search_avx2(bytes, size, pattern, length);
+        case Level::SSSE3:
+        case Level::SSE2:  return details::search_sse2(bytes, size, pattern, length);
+#endif
+        default:           return details::search(bytes, size, pattern, length);
+        }
+    }
+
+    /// Длина начала, целиком состоящего из байтов множества.
+    inline std::size_t span(const void* data, std::size_t size, const ByteSet& set, Level use = level()) noexcept
+    {
+        const auto* bytes = static_cast<const details::Byte*>(data);
+        switch (set.vectorizable() ? use : Level::Scalar) {
+#if LIB_SIMD_X86
+        case Level::AVX2:  return details::span_avx2<true>(bytes, size, set);
+        case Level::SSSE3: return details::span_ssse3<true>(bytes, size, set);
+#endif
+        default:           return details::span<true>(bytes, size, set);
+        }
+    }
+
+    /// Индекс первого байта из множества или npos.
+    inline std::size_t find_first_of(const void* data, std::size_t size, const ByteSet& set, Level use = level()) noexcept
+    {
+        const auto* bytes = static_cast<const details::Byte*>(data);
+        std::size_t index = size;
+        switch (set.vectorizable() ? use : Level::Scalar) {
+#if LIB_SIMD_X86
+        case Level::AVX2:  index = details::span_avx2<false>(bytes, size, set); break;
+        case Level::SSSE3: index = details::span_ssse3<false>(bytes, size, set); break;
+#endif
+        default:           index = details::span<false>(bytes, size, set); break;
+        }
+        return index == size ? npos : index;
+    }
+
+    unittest {
+        constexpr Level levels[] = {Level::Scalar, Level::SSE2, Level::SSSE3, Level::AVX2};
+
+        char text[200] = {};
+        for (std::size_t i = 0; i < sizeof(text); ++i) {
+            text[i] = static_cast<char>('a' + i % 7);
+        }
+        text[150] = '\r';
+        text[151] = '\n';
+        text[170] = '\r';
+        text[171] = '\n';
+
+        for (auto use: levels) {
+            if (use > level()) {
+                continue;
+            }
+            check(find(text, sizeof(text), std::byte('\n'), use) == 151);
+            check(find(text, 150, std::byte('\n'), use) == npos);
+            check(search(text, sizeof(text), "\r\n", 2, use) == 150);
+            check(search(text + 152, sizeof(text) - 152, "\r\n", 2, use) == 18);
+            check(search(text, sizeof(text), "efgab", 5, use) == 4);
+            check(search(text, sizeof(text), "gf", 2, use) == npos);
+            check(equal(text, text, sizeof(text), use));
+            check(!equal(text, text + 7, 140, use) || std::memcmp(text, text + 7, 140) == 0);
+            check(!equal(text, text + 1, sizeof(text) - 1, use));
+            check(equal(static_cast<const char*>(nullptr), static_cast<const char*>(nullptr), 0, use));
+
+            // все смещения и длины, чтобы пройти и векторную часть, и хвост
+            bool same = true;
+            for (std::size_t first = 0; first < 40; ++first) {
+                for (std::size_t size = 0; first + size <= sizeof(text); size += 13) {
+                    const std::string_view view(text + first, size);
+                    same = same && find(view.data(), size, std::byte('\r'), use) == view.find('\r');
+                    same = same && search(view.data(), size, "bcd", 3, use) == view.find("bcd");
+                    same = same && search(view.data(), size, "\n\r", 2, use) == view.find("\n\r");
+                    char copy[sizeof(text)];
+                    std::memcpy(copy, text, sizeof(text));
+                    same = same && equal(view.data(), copy + first, size, use);
+                    if (size != 0) {
+                        copy[first + size - 1] = '\0';
+                        same = same && !equal(view.data(), copy + first, size, use);
+                    }
+                }
+            }
+            check(same);
+        }
+    }
+
+    unittest {
+        constexpr Level levels[] = {Level::Scalar, Level::SSE2, Level::SSSE3, Level::AVX2};
+
+        constexpr auto identifier = ByteSet('a', 'z').insert('A', 'Z').insert('0', '9').insert('_');
+        constexpr ByteSet space(" \t\r\n");
+        static_assert(identifier.vectorizable() && space.vectorizable());
+        static_assert(identifier.contains('q') && !identifier.contains('-') && !identifier.contains(0xC0));
+        static_assert((~space).contains('x') && !(~space).contains(' '));
+
+        // 9 разных столбцов младших полубайтов: таблиц не хватает
+        ByteSet wide;
+        for (unsigned h = 0; h < 9; ++h) {
+            wide.insert(static_cast<std::uint8_t>(h << 4U | h));
+        }
+        check(!wide.vectorizable() && wide.contains(0x88) && !wide.contains(0x89));
+
+        char text[300];
+        for (std::size_t i = 0; i < sizeof(text); ++i) {
+            text[i] = "abcXYZ_019"[i % 10];
+        }
+        text[250] = '(';
+        text[260] = ' ';
+        text[270] = static_cast<char>(0xC0);
+
+        for (auto use: levels) {
+            if (use > level()) {
+                continue;
+            }
+            check(span(text, sizeof(text), identifier, use) == 250);
+            check(span(text + 251, 9, identifier, use) == 9);
+            check(find_first_of(text, sizeof(text), space, use) == 260);
+            check(find_first_of(text, 260, space, use) == npos);
+
+            // каждое смещение и длина против побайтовой проверки, в том числе с байтами > 127
+            bool same = true;
+            for (const ByteSet* set: {&identifier, &space, static_cast<const ByteSet*>(&wide)}) {
+                const ByteSet inverse = ~*set;
+                for (std::size_t first = 0; first < 40; ++first) {
+                    for (std::size_t size = 0; first + size <= sizeof(text); size += 11) {
+                        std::size_t expected = 0;
+                        while (expected < size && set->contains(static_cast<std::uint8_t>(text[first + expected]))) {
+                            ++expected;
+                        }
+                        same = same && span(text + first, size, *set, use) == expected;
+                        const auto found = find_first_of(text + first, size, inverse, use);
+                        same = same && (found == npos ? expected == size : found == expected);
+                    }
+                }
+            }
+            check(same);
+        }
+    }
+}
@@ -35,6 +35,32 @@ namespace lib {
         {
             return buffer.rpoll();
         }
+        Event& event() const noexcept
+        {
+            return ievent;
+        }
+        std::size_t poll() const noexcept
+        {
+            return buffer.rsize();
+        }
+        T& peek() noexcept
+        {
+            return buffer.front();
+        }
+        void next() noexcept
+        {
+            buffer.pop();
+            oevent.emit();
+        }
+        Span<T> chunk() noexcept
+        {
+            return buffer.rspan();
+        }
+        void next(std::size_t count) noexcept
+        {
+            buffer.skip(count);
+            oevent.emit();
+        }
         Event& sevent() const noexcept
         {
             return oevent;
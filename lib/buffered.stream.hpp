@@ -4,32 +4,256 @@
 #include <lib/channel.hpp>
 #include <lib/buffered.channel.hpp>
 
+#include <array>
+#include <cstring>
+
 namespace lib {
-    template <class T, std::size_t N>
+
+    /// Поток байт между потоками без копирования. Writer заполняет блоки
+    /// buffer::Fill<std::byte> и отправляет их в i_buffers как Owner<std::byte>,
+    /// Reader возвращает прочитанные блоки в o_buffers, откуда Writer берёт их снова.
+    /// Всего блоков не больше 2 * N + 2, поэтому память после разгона не выделяется;
+    /// o_buffers вмещает их все, и возврат блока никогда не теряется.
+    template <std::size_t N, std::size_t BlockSize = 4096>
     class BufferedStream
     {
+        using Block = buffer::Owner<std::byte>;
+
+        constexpr static inline std::size_t max_blocks = 2 * N + 2;
+
+        BufferedChannel<Block, N> i_buffers;
+        BufferedChannel<Block, max_blocks> o_buffers;
 
     public:
+        class Writer;
+        class Reader;
 
+        constexpr static std::size_t block_size() noexcept
+        {
+            return BlockSize;
+        }
     };
 
-    template <class T>
-    class IStream
+    template <std::size_t N, std::size_t BlockSize>
+    class BufferedStream<N, BlockSize>::Writer
     {
-        BufferedChannel<T, 8> i_buffers;
-        BufferedChannel<T, 8> o_buffers;
+        BufferedStream& stream;
+        buffer::Fill<std::byte> block;
+        std::size_t allocated = 0;
     public:
-
+        explicit Writer(BufferedStream& stream) noexcept
+        : stream(stream)
+        {}
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer() noexcept
+        {
+            close();
+        }
+    public:
+        /// Свободное место текущего блока; записанное подтверждается commit().
+        /// Пустое, если читатель уже закрыл поток.
+        buffer::ViewImpl<std::byte> prepare()
+        {
+            if (block.full()) {
+                flush();
+                if (!acquire()) {
+                    return {};
+                }
+            }
+            return block.space();
+        }
+        void commit(std::size_t size) noexcept
+        {
+            block.commit(size);
+        }
+        /// false, если читатель закрыл поток и данные записаны не полностью.
+        bool write(buffer::ViewImpl<const std::byte> data)
+        {
+            while (!data.empty()) {
+                auto space = prepare();
+                if (space.empty()) {
+                    return false;
+                }
+                const auto size = std::min(space.size(), data.size());
+                std::memcpy(space.data(), data.data(), size);
+                commit(size);
+                data = buffer::ViewImpl<const std::byte>(data.data() + size, data.size() - size);
+            }
+            return true;
+        }
+        /// Отправляет читателю текущий блок, даже неполный.
+        void flush()
+        {
+            if (!block.empty()) {
+                stream.i_buffers.send(block.take());
+            }
+        }
+        void close()
+        {
+            if (!stream.i_buffers.closed()) {
+                flush();
+                stream.i_buffers.close();
+            }
+        }
+    private:
+        /// false, если свободных блоков нет и не будет: читатель закрыл поток.
+        bool acquire()
+        {
+            auto& recycled = stream.o_buffers;
+            while (recycled.poll()) {
+                auto used = std::move(recycled.peek());
+                recycled.next();
+                if (block.recycle(std::move(used))) {
+                    return true;
+                }
+                // на блок ещё ссылается читатель, память освободится вместе с ним
+                allocated -= 1;
+            }
+            if (allocated < max_blocks) {
+                block = buffer::Fill<std::byte>(BlockSize);
+                allocated += 1;
+                return true;
+            }
+            Subscriber subscriber(recycled.event());
+            if (!wait(subscriber, recycled)) {
+                return false;
+            }
+            auto used = std::move(recycled.peek());
+            recycled.next();
+            if (!block.recycle(std::move(used))) {
+                // взамен блока, который ещё держат снаружи: счётчик не меняется
+                block = buffer::Fill<std::byte>(BlockSize);
+            }
+            return true;
+        }
     };
 
-    template <class Buffers, class IStream>
-    class StreamReceiver
+    /// Читатель потока. chunk() отдаёт остаток текущего блока без копирования,
+    /// peek(n) - непрерывные n байт: если они лежат в двух блоках, байты копируются
+    /// во встроенный буфер размера BlockSize.
+    template <std::size_t N, std::size_t BlockSize>
+    class BufferedStream<N, BlockSize>::Reader
     {
-        Buffers& buffers;
-        IStream& istream;
+        using View = buffer::ViewImpl<const std::byte>;
+
+        BufferedStream& stream;
+        Block current;
+        std::size_t offset = 0;
+
+        std::array<std::byte, BlockSize> scratch;
+        std::size_t scratch_begin = 0;
+        std::size_t scratch_end   = 0;
+    public:
+        explicit Reader(BufferedStream& stream) noexcept
+        : stream(stream)
+        {}
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        /// Писатель, ждущий свободный блок или место в i_buffers, получает отказ.
+        ~Reader() noexcept
+        {
+            stream.o_buffers.close();
+            stream.i_buffers.close();
+        }
     public:
+        /// Ждёт данные и возвращает непрерывный кусок потока; пустой - если поток закрыт.
+        View chunk()
+        {
+            if (scratch_begin != scratch_end) {
+                return View(scratch.data() + scratch_begin, scratch_end - scratch_begin);
+            }
+            if (offset == current.size() && !pull()) {
+                return View();
+            }
+            return View(current.data() + offset, current.size() - offset);
+        }
+
+        /// Непрерывные n байт или меньше, если поток закрылся раньше;
+        /// n больше BlockSize урезается до BlockSize.
+        View peek(std::size_t n)
+        {
+            n = std::min(n, BlockSize);
+            if (scratch_begin == scratch_end && current.size() - offset >= n) {
+                return View(current.data() + offset, n);
+            }
+            if (scratch_begin != 0) {
+                std::memmove(scratch.data(), scratch.data() + scratch_begin, scratch_end - scratch_begin);
+                scratch_end -= scratch_begin;
+                scratch_begin = 0;
+            }
+            while (scratch_end < n) {
+                if (offset == current.size() && !pull()) {
+                    break;
+                }
+                const auto size = std::min(n - scratch_end, current.size() - offset);
+                std::memcpy(scratch.data() + scratch_end, current.data() + offset, size);
+                scratch_end += size;
+                offset += size;
+            }
+            return View(scratch.data(), std::min(n, scratch_end));
+        }
+
+        void consume(std::size_t n) noexcept
+        {
+            const auto buffered = std::min(n, scratch_end - scratch_begin);
+            scratch_begin += buffered;
+            if (scratch_begin == scratch_end) {
+                scratch_begin = scratch_end = 0;
+            }
+            offset += n - buffered;
+            if (offset == current.size()) {
+                recycle();
+            }
+        }
+
+        std::size_t read(buffer::ViewImpl<std::byte> out)
+        {
+            std::size_t count = 0;
+            while (count < out.size()) {
+                auto data = chunk();
+                if (data.empty()) {
+                    break;
+                }
+                const auto size = std::min(data.size(), out.size() - count);
+                std::memcpy(out.data() + count, data.data(), size);
+                consume(size);
+                count += size;
+            }
+            return count;
+        }
 
+        bool closed() const noexcept
+        {
+            return scratch_begin == scratch_end
+                && offset == current.size()
+                && stream.i_buffers.poll() == 0
+                && stream.i_buffers.closed();
+        }
+    private:
+        bool pull()
+        {
+            recycle();
+            auto& blocks = stream.i_buffers;
+            Subscriber subscriber(blocks.event());
+            if (!wait(subscriber, blocks)) {
+                return false;
+            }
+            current = std::move(blocks.peek());
+            blocks.next();
+            offset = 0;
+            return true;
+        }
 
+        /// o_buffers вмещает все блоки потока, поэтому места хватает всегда.
+        void recycle() noexcept
+        {
+            if (current.data() != nullptr && stream.o_buffers.spoll()) {
+                stream.o_buffers.usend(std::move(current));
+            }
+            current = Block();
+            offset = 0;
+        }
     };
 }
-#endif
\ No newline at end of file
+#endif
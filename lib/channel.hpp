@@ -4,8 +4,14 @@
 #include <lib/buffer.hpp>
 #include <lib/overload.hpp>
 #include <lib/raw.storage.hpp>
+#include <lib/array.hpp>
 
+#include <algorithm>
 #include <variant>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <limits>
 #include <bitset>
 #include <numeric>
 #include <stdexcept>
@@ -51,16 +57,16 @@ namespace lib {
         auto recv()
         {
             auto& self = *static_cast<Channel*>(this);
-            if (self.poll(ichannel)) {
-                return self.peek(ichannel);
-            }
-
-            Subscriber subscriber(self.event(ichannel));
+            if (!self.poll()) {
+                Subscriber subscriber(self.event());
 
-            if (wait(subscriber, self)) {
-                return self.peek(ichannel);
+                if (!wait(subscriber, self)) {
+                    throw std::out_of_range("channel is closed");
+                }
             }
-            throw std::out_of_range("channel is closed");
+            auto value = self.peek();
+            self.next();
+            return value;
         }
 
         auto arecv() noexcept
@@ -69,77 +75,263 @@ namespace lib {
         }
     };
 
-    /*template <class T>
-    class VIChannel: public IChannel<VIChannel<T>>
+    namespace details {
+        /// Хранилище канала для VIChannel/VOChannel. Lvalue-канал хранится по ссылке,
+        /// rvalue (например, адаптер) перемещается во встроенный буфер размера Size,
+        /// а если не помещается - в кучу. Interface должен содержать relocate и destroy.
+        template <class Interface, std::size_t Size>
+        class ErasedChannel
+        {
+        protected:
+            const Interface* interface = nullptr;
+            void*            channel   = nullptr;
+            alignas(std::max_align_t) std::byte buffer[Size];
+
+            template <class Channel>
+            constexpr static bool is_inline = sizeof(Channel) <= Size
+                && alignof(Channel) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<Channel>;
+
+            template <class Channel>
+            constexpr static void (*relocate)(ErasedChannel& to, ErasedChannel& from) noexcept =
+                [] (ErasedChannel& to, ErasedChannel& from) noexcept {
+                    if constexpr (is_inline<Channel>) {
+                        auto* channel = static_cast<Channel*>(from.channel);
+                        to.channel = new (to.buffer) Channel(std::move(*channel));
+                        channel->~Channel();
+                    } else {
+                        to.channel = from.channel;
+                    }
+                };
+
+            template <class Channel>
+            constexpr static void (*destroy)(void* channel) noexcept =
+                [] (void* channel) noexcept {
+                    if constexpr (is_inline<Channel>) {
+                        static_cast<Channel*>(channel)->~Channel();
+                    } else {
+                        delete static_cast<Channel*>(channel);
+                    }
+                };
+
+        protected:
+            template <class Channel>
+            ErasedChannel(const Interface* interface, Channel& channel) noexcept
+            : interface(interface)
+            , channel(&channel)
+            {}
+
+            template <class Channel>
+            ErasedChannel(const Interface* interface, Channel&& channel)
+            : interface(interface)
+            {
+                if constexpr (is_inline<Channel>) {
+                    this->channel = new (buffer) Channel(std::move(channel));
+                } else {
+                    this->channel = new Channel(std::move(channel));
+                }
+            }
+
+        public:
+            ErasedChannel(ErasedChannel&& other) noexcept
+            {
+                steal(other);
+            }
+
+            ErasedChannel& operator=(ErasedChannel&& other) noexcept
+            {
+                if (this != &other) {
+                    reset();
+                    steal(other);
+                }
+                return *this;
+            }
+
+            ~ErasedChannel() noexcept
+            {
+                reset();
+            }
+
+        private:
+            void steal(ErasedChannel& other) noexcept
+            {
+                interface = other.interface;
+                channel = other.channel;
+                if (interface != nullptr && interface->relocate != nullptr) {
+                    interface->relocate(*this, other);
+                }
+                other.interface = nullptr;
+                other.channel = nullptr;
+            }
+
+            void reset() noexcept
+            {
+                if (interface != nullptr && interface->destroy != nullptr) {
+                    interface->destroy(channel);
+                }
+                interface = nullptr;
+                channel = nullptr;
+            }
+        };
+    }
+
+    /// Канал для чтения со стёртым типом. Таблица функций одна на тип канала,
+    /// recv(Span<T>) забирает до out.size() сообщений за один косвенный вызов.
+    template <class T, std::size_t Size = 4 * sizeof(void*)>
+    class VIChannel: public IChannelBase<VIChannel<T, Size>>
     {
         struct Interface
         {
-            T      (*urecv)(void* channel) noexcept;
-            void   (*close)(void* channel) noexcept;
-            bool   (*closed)(const void* channel) noexcept;
-            bool   (*rpoll) (const void* channel) noexcept;
+            std::size_t (*poll)  (const void* channel) noexcept;
+            T           (*peek)  (void* channel);
+            void        (*next)  (void* channel);
+            std::size_t (*recv)  (void* channel, Span<T> out);
+            IEvent&     (*event) (const void* channel) noexcept;
+            bool        (*closed)(const void* channel) noexcept;
+            void        (*close) (void* channel) noexcept;
+
+            void (*relocate)(details::ErasedChannel<Interface, Size>& to, details::ErasedChannel<Interface, Size>& from) noexcept;
+            void (*destroy) (void* channel) noexcept;
         };
-    private:
-        const Interface* interface = nullptr;
-        void* channel = nullptr;
-        mutable IEvent event;
+
+        class Storage: public details::ErasedChannel<Interface, Size>
+        {
+            using Base = details::ErasedChannel<Interface, Size>;
+            friend class VIChannel;
+        public:
+            template <class Channel>
+            Storage(Channel&& channel)
+            : Base(implement<std::remove_cvref_t<Channel>, std::is_lvalue_reference_v<Channel>>(), std::forward<Channel>(channel))
+            {}
+
+            template <class Channel, bool Reference>
+            static const Interface* implement() noexcept
+            {
+                static_assert(std::is_base_of_v<IEvent, std::remove_reference_t<decltype(std::declval<const Channel&>().event())>>,
+                    "event of the channel must be derived from lib::IEvent");
+
+                static const Interface interface = {
+                    [] (const void* channel) noexcept -> std::size_t {
+                        return static_cast<const Channel*>(channel)->poll();
+                    },
+                    [] (void* channel) -> T {
+                        return static_cast<Channel*>(channel)->peek();
+                    },
+                    [] (void* channel) {
+                        static_cast<Channel*>(channel)->next();
+                    },
+                    [] (void* channel, Span<T> out) -> std::size_t {
+                        return VIChannel::take(*static_cast<Channel*>(channel), out);
+                    },
+                    [] (const void* channel) noexcept -> IEvent& {
+                        return static_cast<const Channel*>(channel)->event();
+                    },
+                    [] (const void* channel) noexcept {
+                        return static_cast<const Channel*>(channel)->closed();
+                    },
+                    [] (void* channel) noexcept {
+                        static_cast<Channel*>(channel)->close();
+                    },
+                    Reference ? nullptr : Base::template relocate<Channel>,
+                    Reference ? nullptr : Base::template destroy<Channel>
+                };
+                return &interface;
+            }
+        };
+
+        Storage storage;
+
     public:
         using Type = T;
-        using REvent = IEvent;
+        using Event = IEvent;
+        using IChannelBase<VIChannel>::recv;
+
     public:
         template <class Channel>
-        VIChannel(Channel& channel) noexcept
-        : channel(&channel)
-        , event(channel.revent())
-        {
-            static const Interface implement = {
-                [](void* channel) noexcept {
-                    return static_cast<Channel*>(channel)->urecv();
-                },
-                [](void* channel) noexcept {
-                    static_cast<Channel*>(channel)->close();
-                },
-                [](const void* channel) noexcept {
-                    return static_cast<const Channel*>(channel)->closed();
-                },
-                [](const void* channel) noexcept {
-                    return static_cast<const Channel*>(channel)->rpoll();
-                }
-            };
-            interface = &implement;
-        }
-    public:
-        VIChannel(const VIChannel&) = default;
-        VIChannel(VIChannel&&) = default;
-        VIChannel& operator=(const VIChannel&) = default;
-        VIChannel& operator=(VIChannel&&) = default;
+        requires (!std::is_same_v<std::remove_cvref_t<Channel>, VIChannel>)
+        VIChannel(Channel&& channel) // NOLINT
+        : storage(std::forward<Channel>(channel))
+        {}
+
+        VIChannel(VIChannel&&) noexcept = default;
+        VIChannel& operator=(VIChannel&&) noexcept = default;
+
     public:
-        T urecv()
+        std::size_t poll() const noexcept
         {
-            return interface->urecv(channel);
+            return storage.interface->poll(storage.channel);
         }
 
-        void close() noexcept
+        T peek()
+        {
+            return storage.interface->peek(storage.channel);
+        }
+
+        void next()
         {
-            interface->close(channel);
+            storage.interface->next(storage.channel);
         }
+
+        /// Ждёт хотя бы одно сообщение и забирает до out.size() сообщений.
+        /// Возвращает 0, только если канал закрыт.
+        std::size_t recv(Span<T> out)
+        {
+            if (out.empty()) {
+                return 0;
+            }
+            if (!poll()) {
+                Subscriber subscriber(event());
+                if (!wait(subscriber, *this)) {
+                    return 0;
+                }
+            }
+            return storage.interface->recv(storage.channel, out);
+        }
+
+        Event& event() const noexcept
+        {
+            return storage.interface->event(storage.channel);
+        }
+
         bool closed() const noexcept
         {
-            return interface->closed(channel);
+            return storage.interface->closed(storage.channel);
         }
 
-        IEvent& revent() const noexcept
+        void close() noexcept
         {
-            return event;
+            storage.interface->close(storage.channel);
         }
-        bool rpoll() const noexcept
+
+    private:
+        template <class Channel>
+        static std::size_t take(Channel& channel, Span<T> out)
         {
-            return interface->rpoll(channel);
+            std::size_t count = 0;
+            if constexpr (requires { channel.chunk(); channel.next(count); }) {
+                while (count < out.size()) {
+                    auto chunk = channel.chunk();
+                    auto size = std::min(chunk.size(), out.size() - count);
+                    if (size == 0) {
+                        break;
+                    }
+                    std::move(chunk.begin(), chunk.begin() + size, out.begin() + count);
+                    channel.next(size);
+                    count += size;
+                }
+            } else {
+                auto size = std::min(channel.poll(), out.size());
+                for (; count < size; ++count) {
+                    out[count] = std::move(channel.peek());
+                    channel.next();
+                }
+            }
+            return count;
         }
     };
 
     template <class Channel>
-    VIChannel(Channel& channel) -> VIChannel<typename Channel::Type>;*/
+    VIChannel(Channel&& channel) -> VIChannel<std::remove_cvref_t<typename std::remove_reference_t<Channel>::Type>>;
 
     template <class ...Channels>
     class ChannelAny: public IChannelBase<ChannelAny<Channels...>>
@@ -274,7 +466,7 @@ namespace lib {
     {
     public:
         using Type = std::tuple<typename Channels::Type...>;
-        using Event = EventMux<typename Channels::REvent&...>;
+        using Event = EventMux<std::remove_reference_t<decltype(std::declval<const Channels&>().event())> ...>;
 
     private:
         std::tuple<Channels&...>                 channels;
@@ -322,9 +514,9 @@ namespace lib {
         template <std::size_t ...I>
         std::size_t poll(std::index_sequence<I...>) const noexcept
         {
-            using Function = bool (*)(const ChannelAll*);
+            using Function = std::size_t (*)(const ChannelAll*);
             static const std::array<Function, sizeof...(Channels)> function {
-                [] (const ChannelAll* channel) {
+                [] (const ChannelAll* channel) -> std::size_t {
                     return std::get<I>(channel->channels).poll();
                 }...
             };
@@ -354,6 +546,9 @@ namespace lib {
         void next(std::index_sequence<I...>)
         {
             (std::get<I>(channels).next(), ...);
+            for (auto& size: sizes) {
+                size -= 1;
+            }
         }
 
         template <std::size_t ...I>
@@ -371,6 +566,198 @@ namespace lib {
     template <typename... Channels>
     ChannelAll(Channels&... channels) -> ChannelAll<Channels...>;
 
+    /// Источник для ChannelSelect.
+    template <class Channel>
+    struct SelectSource
+    {
+        Channel&      channel;
+        std::uint8_t  priority   = 0; // готовый источник с большим приоритетом вытесняет остальные
+        std::uint16_t weight     = 1; // доля выборок среди источников одного приоритета
+        std::uint16_t starvation = 0; // сколько выборок подряд готовый источник может пропустить, 0 - сколько угодно
+    };
+
+    template <class Channel>
+    constexpr SelectSource<Channel> select_source(Channel& channel, std::uint8_t priority = 0, std::uint16_t weight = 1, std::uint16_t starvation = 0) noexcept
+    {
+        return {channel, priority, weight, starvation};
+    }
+
+    /// Как ChannelAny, но источник выбирается по приоритету, а внутри одного
+    /// приоритета - взвешенным round-robin (smooth weighted round-robin).
+    /// Источник, пропустивший starvation выборок подряд, выбирается вне очереди.
+    template <class ...Channels>
+    class ChannelSelect: public IChannelBase<ChannelSelect<Channels...>>
+    {
+        constexpr static inline std::size_t count = sizeof...(Channels);
+        constexpr static inline std::size_t npos  = count;
+    public:
+        using Type = std::variant<std::remove_cvref_t<typename Channels::Type> ...>;
+        using Event = EventMux<std::remove_reference_t<decltype(std::declval<const Channels&>().event())> ...>;
+
+    private:
+        std::tuple<Channels&...> channels;
+        mutable Event            events;
+
+        std::array<std::uint8_t, count>  priorities;
+        std::array<std::uint16_t, count> weights;
+        std::array<std::uint16_t, count> starvations;
+
+        mutable std::size_t current = npos;
+        mutable std::array<std::size_t, count>   sizes{};
+        mutable std::array<std::int64_t, count>  credits{};
+        mutable std::array<std::uint32_t, count> skipped{};
+
+    public:
+        constexpr ChannelSelect(SelectSource<Channels>... sources) noexcept
+        : channels{sources.channel...}
+        , events{sources.channel.event()...}
+        , priorities{sources.priority...}
+        , weights{sources.weight...}
+        , starvations{sources.starvation...}
+        {}
+
+        std::size_t poll() const noexcept
+        {
+            return poll(std::make_index_sequence<count>{});
+        }
+
+        bool closed() const noexcept
+        {
+            return closed(std::make_index_sequence<count>{});
+        }
+
+        void close() noexcept
+        {
+            close(std::make_index_sequence<count>{});
+        }
+
+        Event& event() const noexcept
+        {
+            return events;
+        }
+
+        /// Индекс источника, из которого будет прочитано следующее сообщение.
+        std::size_t index() const noexcept
+        {
+            return current;
+        }
+
+        Type peek()
+        {
+            return peek(std::make_index_sequence<count>{});
+        }
+
+        void next()
+        {
+            next(std::make_index_sequence<count>{});
+            sizes[current] -= 1;
+            current = npos;
+        }
+
+    private:
+        template <std::size_t ...I>
+        std::size_t poll(std::index_sequence<I...>) const noexcept
+        {
+            using Function = std::size_t (*)(const ChannelSelect*);
+            static const std::array<Function, count> function {
+                [] (const ChannelSelect* channel) -> std::size_t {
+                    return std::get<I>(channel->channels).poll();
+                }...
+            };
+
+            std::size_t total = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (sizes[i] == 0) {
+                    sizes[i] = function[i](this);
+                    events.set_reset_mask(i, sizes[i] != 0);
+                }
+                total += sizes[i];
+            }
+            if (total != 0 && current == npos) {
+                select();
+            }
+            return total;
+        }
+
+        void select() const noexcept
+        {
+            std::size_t starving = npos;
+            std::uint8_t top = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (sizes[i] == 0) {
+                    continue;
+                }
+                if (starvations[i] != 0 && skipped[i] >= starvations[i]) {
+                    if (starving == npos || skipped[i] > skipped[starving]) {
+                        starving = i;
+                    }
+                }
+                top = std::max(top, priorities[i]);
+            }
+
+            current = starving;
+            if (current == npos) {
+                std::int64_t total = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (sizes[i] != 0 && priorities[i] == top) {
+                        credits[i] += weights[i];
+                        total += weights[i];
+                        if (current == npos || credits[i] > credits[current]) {
+                            current = i;
+                        }
+                    }
+                }
+                credits[current] -= total;
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                if (i == current) {
+                    skipped[i] = 0;
+                } else if (sizes[i] != 0 && skipped[i] != std::numeric_limits<std::uint32_t>::max()) {
+                    skipped[i] += 1;
+                }
+            }
+        }
+
+        template <std::size_t ...I>
+        Type peek(std::index_sequence<I...>)
+        {
+            using Function = Type (*)(ChannelSelect*);
+            static const std::array<Function, count> function {
+                [] (ChannelSelect* channel) -> Type {
+                    return Type(std::in_place_index<I>, std::get<I>(channel->channels).peek());
+                }...
+            };
+            return function[current](this);
+        }
+
+        template <std::size_t ...I>
+        void next(std::index_sequence<I...>)
+        {
+            using Function = void (*)(ChannelSelect*);
+            static const std::array<Function, count> function {
+                [] (ChannelSelect* channel) {
+                    std::get<I>(channel->channels).next();
+                }...
+            };
+            function[current](this);
+        }
+
+        template <std::size_t ...I>
+        bool closed(std::index_sequence<I...>) const noexcept
+        {
+            return (std::get<I>(channels).closed() && ...);
+        }
+
+        template <std::size_t ...I>
+        void close(std::index_sequence<I...>) noexcept
+        {
+            (std::get<I>(channels).close(), ...);
+        }
+    };
+    template <typename... Channels>
+    ChannelSelect(SelectSource<Channels>... sources) -> ChannelSelect<Channels...>;
+
     template <class Channel>
     class IRange
     {
@@ -460,6 +847,98 @@ namespace lib {
         return IRange<Channel>(channel);
     }
 
+    /// Чтение "пачками": итератор возвращает непрерывный участок (Span) всех сообщений,
+    /// доступных на момент опроса, и освобождает его целиком при переходе к следующему.
+    /// Канал должен предоставлять chunk() и next(count), например BufferedChannel.
+    template <class Channel>
+    class IBatchRange
+    {
+        friend class Iterator;
+    private:
+        using Chunk = decltype(std::declval<Channel&>().chunk());
+        using Event = std::remove_reference_t<decltype(std::declval<const Channel&>().event())>;
+
+        Channel& channel;
+        Subscriber<Event> subscriber;
+        Chunk chunk;
+    public:
+        class Iterator
+        {
+            IBatchRange *range;
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = Chunk;
+            using pointer           = const Chunk*;
+            using reference         = const Chunk&;
+        private:
+            void next()
+            {
+                auto& channel = range->channel;
+                if (channel.poll() || wait(range->subscriber, channel)) {
+                    range->chunk = channel.chunk();
+                } else {
+                    range = nullptr;
+                }
+            }
+        public:
+            Iterator(IBatchRange *range) noexcept
+            : range(range)
+            {
+                if (range) {
+                    next();
+                }
+            }
+            reference operator*() const noexcept
+            {
+                return range->chunk;
+            }
+            pointer operator->() const noexcept
+            {
+                return &range->chunk;
+            }
+            Iterator& operator++()
+            {
+                range->channel.next(range->chunk.size());
+                range->chunk = Chunk();
+
+                next();
+                return *this;
+            }
+            friend bool operator==(const Iterator& a, const Iterator& b) noexcept
+            {
+                return a.range == b.range;
+            }
+            friend bool operator!=(const Iterator& a, const Iterator& b) noexcept
+            {
+                return a.range != b.range;
+            }
+        };
+    public:
+        constexpr IBatchRange(Channel& channel) noexcept
+        : channel(channel)
+        , subscriber(channel.event())
+        {}
+
+        auto begin()
+        {
+            return Iterator(this);
+        }
+        auto end()
+        {
+            return Iterator(nullptr);
+        }
+    public:
+        IBatchRange(const IBatchRange& range) = delete;
+        IBatchRange& operator=(const IBatchRange& range) = delete;
+    };
+
+    template <class Channel>
+    auto ibatch(Channel& channel)
+    {
+        return IBatchRange<Channel>(channel);
+    }
+
     template <class Channel>
     class OChannel
     {
@@ -497,80 +976,131 @@ namespace lib {
         }
     };
 
-    template <class T>
-    class VOChannel: public OChannel<VOChannel<T>>
+    /// Канал для записи со стёртым типом. send(Span<T>) отправляет пачку сообщений,
+    /// перемещая их из values, за один косвенный вызов на каждое пробуждение.
+    template <class T, std::size_t Size = 4 * sizeof(void*)>
+    class VOChannel: public OChannel<VOChannel<T, Size>>
     {
         struct Interface
         {
-            void   (*usend)(void* channel, T value) noexcept;
-            void   (*close)(void* channel) noexcept;
-            bool   (*closed)(const void* channel) noexcept;
-            bool   (*spoll) (const void* channel) noexcept;
+            void        (*usend) (void* channel, T value);
+            std::size_t (*send)  (void* channel, Span<T> values);
+            bool        (*spoll) (const void* channel) noexcept;
+            IEvent&     (*sevent)(const void* channel) noexcept;
+            bool        (*closed)(const void* channel) noexcept;
+            void        (*close) (void* channel) noexcept;
+
+            void (*relocate)(details::ErasedChannel<Interface, Size>& to, details::ErasedChannel<Interface, Size>& from) noexcept;
+            void (*destroy) (void* channel) noexcept;
         };
 
-    private:
-        const Interface* interface = nullptr;
-        void* channel = nullptr;
-        mutable Event event;
+        class Storage: public details::ErasedChannel<Interface, Size>
+        {
+            using Base = details::ErasedChannel<Interface, Size>;
+            friend class VOChannel;
+        public:
+            template <class Channel>
+            Storage(Channel&& channel)
+            : Base(implement<std::remove_cvref_t<Channel>, std::is_lvalue_reference_v<Channel>>(), std::forward<Channel>(channel))
+            {}
+
+            template <class Channel, bool Reference>
+            static const Interface* implement() noexcept
+            {
+                static_assert(std::is_base_of_v<IEvent, std::remove_reference_t<decltype(std::declval<const Channel&>().sevent())>>,
+                    "event of the channel must be derived from lib::IEvent");
+
+                static const Interface interface = {
+                    [] (void* channel, T value) {
+                        static_cast<Channel*>(channel)->usend(std::move(value));
+                    },
+                    [] (void* channel, Span<T> values) -> std::size_t {
+                        auto& self = *static_cast<Channel*>(channel);
+                        std::size_t count = 0;
+                        while (count < values.size() && self.spoll()) {
+                            self.usend(std::move(values[count]));
+                            count += 1;
+                        }
+                        return count;
+                    },
+                    [] (const void* channel) noexcept {
+                        return static_cast<const Channel*>(channel)->spoll();
+                    },
+                    [] (const void* channel) noexcept -> IEvent& {
+                        return static_cast<const Channel*>(channel)->sevent();
+                    },
+                    [] (const void* channel) noexcept {
+                        return static_cast<const Channel*>(channel)->closed();
+                    },
+                    [] (void* channel) noexcept {
+                        static_cast<Channel*>(channel)->close();
+                    },
+                    Reference ? nullptr : Base::template relocate<Channel>,
+                    Reference ? nullptr : Base::template destroy<Channel>
+                };
+                return &interface;
+            }
+        };
+
+        Storage storage;
 
     public:
         using Type = T;
-        using SEvent = Event;
+        using SEvent = IEvent;
+        using OChannel<VOChannel>::send;
 
     public:
         template <class Channel>
-        VOChannel(Channel& channel) noexcept
-        : channel(&channel)
-        , event(channel.sevent())
-        {
-            static const Interface implement = {
-                [](void* channel, T value) noexcept {
-                    static_cast<Channel*>(channel)->usend(std::move(value));
-                },
-                [](void* channel) noexcept {
-                    static_cast<Channel*>(channel)->close();
-                },
-                [](const void* channel) noexcept {
-                    return static_cast<const Channel*>(channel)->closed();
-                },
-                [](const void* channel) noexcept {
-                    return static_cast<const Channel*>(channel)->spoll();
-                }
-            };
-            interface = &implement;
-        }
-    public:
-        VOChannel(const VOChannel&) = default;
-        VOChannel(VOChannel&&) = default;
-        VOChannel& operator=(const VOChannel&) = default;
-        VOChannel& operator=(VOChannel&&) = default;
+        requires (!std::is_same_v<std::remove_cvref_t<Channel>, VOChannel>)
+        VOChannel(Channel&& channel) // NOLINT
+        : storage(std::forward<Channel>(channel))
+        {}
+
+        VOChannel(VOChannel&&) noexcept = default;
+        VOChannel& operator=(VOChannel&&) noexcept = default;
+
     public:
         void usend(T value)
         {
-            interface->usend(channel, value);
+            storage.interface->usend(storage.channel, std::move(value));
+        }
+
+        /// Отправляет все values, пока канал не закроется. Возвращает число отправленных.
+        std::size_t send(Span<T> values)
+        {
+            std::size_t count = storage.interface->send(storage.channel, values);
+            if (count == values.size()) {
+                return count;
+            }
+
+            Subscriber subscriber(sevent());
+            while (count < values.size() && this->swait(subscriber, *this)) {
+                count += storage.interface->send(storage.channel, Span<T>(values.data() + count, values.size() - count));
+            }
+            return count;
         }
 
         void close() noexcept
         {
-            interface->close(channel);
+            storage.interface->close(storage.channel);
         }
         bool closed() const noexcept
         {
-            return interface->closed(channel);
+            return storage.interface->closed(storage.channel);
         }
 
         SEvent& sevent() const noexcept
         {
-            return event;
+            return storage.interface->sevent(storage.channel);
         }
         bool spoll() const noexcept
         {
-            return interface->spoll(channel);
+            return storage.interface->spoll(storage.channel);
         }
     };
 
     template <class Channel>
-    VOChannel(Channel& channel) -> VOChannel<typename Channel::Type>;
+    VOChannel(Channel&& channel) -> VOChannel<typename std::remove_reference_t<Channel>::Type>;
 
     template <class T>
     class IOChannel: public IChannel<T>, public OChannel<T>
@@ -5,6 +5,7 @@
 #include <lib/units/si/time.hpp>
 #include <coroutine>
 #include <list>
+#include <memory_resource>
 
 namespace lib {
     template <class T>
@@ -21,11 +22,11 @@ namespace lib {
     };
 
     template <>
-    class EventMux<std::list<EventAwaiter*>>
+    class EventMux<std::pmr::list<EventAwaiter*>>
     {
-        const std::list<EventAwaiter*>& awaiters;
+        const std::pmr::list<EventAwaiter*>& awaiters;
     public:
-        constexpr explicit EventMux(const std::list<EventAwaiter*>& awaiters) noexcept
+        constexpr explicit EventMux(const std::pmr::list<EventAwaiter*>& awaiters) noexcept
         : awaiters(awaiters)
         {}
 
@@ -259,9 +260,9 @@ namespace lib {
 
     class Scheduler
     {
-        std::list<std::coroutine_handle<>> ready_tasks;
-        std::list<EventAwaiter*> block_list;
-        std::list<std::coroutine_handle<>> gc_tasks;
+        std::pmr::list<std::coroutine_handle<>> ready_tasks;
+        std::pmr::list<EventAwaiter*> block_list;
+        std::pmr::list<std::coroutine_handle<>> gc_tasks;
 
         auto operator co_await()
         {
@@ -293,6 +294,13 @@ namespace lib {
 
         const Task<void> gc = garbage_collector(*this);
     public:
+        /// Узлы очередей задач выделяются из memory, например из lib::Arena.
+        explicit Scheduler(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : ready_tasks(memory)
+        , block_list(memory)
+        , gc_tasks(memory)
+        {}
+
         template <class T>
         void bind(Task<T> task)
         {
@@ -348,7 +356,7 @@ namespace lib {
         void run()
         {
             Handler handler;
-            EventMux<std::list<EventAwaiter*>> blocks(block_list);
+            EventMux<std::pmr::list<EventAwaiter*>> blocks(block_list);
 
             while (!ready_tasks.empty() || !block_list.empty()) {
                 if (!ready_tasks.empty()) {
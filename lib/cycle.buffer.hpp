@@ -3,6 +3,8 @@
 #include <array>
 #include <atomic>
 #include <lib/raw.storage.hpp>
+#include <lib/array.hpp>
+#include <lib/test.hpp>
 
 namespace lib {
 
@@ -142,6 +144,39 @@ namespace lib {
         {
             return wsize() > 0;
         }
+    public:
+        T& front() noexcept
+        {
+            return *array[m_recv_index.load()].ptr();
+        }
+        void pop() noexcept
+        {
+            skip(1);
+        }
+        /// Непрерывный участок готовых к чтению элементов, начиная с текущего.
+        /// Если данные в буфере "переходят" через конец массива, возвращается только
+        /// первая часть, вторая станет доступна после skip(rspan().size()).
+        Span<T> rspan() noexcept
+        {
+            const auto send_index = m_send_index.load();
+            const auto recv_index = m_recv_index.load();
+            const auto last = send_index >= recv_index ? send_index : array.size();
+            return Span<T>(array[recv_index].ptr(), last - recv_index);
+        }
+        /// Удаляет count элементов одним обновлением индекса чтения,
+        /// count не должен превышать rsize().
+        void skip(std::size_t count) noexcept
+        {
+            auto recv_index = m_recv_index.load();
+            for (std::size_t i = 0; i < count; ++i) {
+                array[recv_index].destroy();
+                recv_index += 1;
+                if (recv_index == array.size()) {
+                    recv_index = 0;
+                }
+            }
+            m_recv_index.store(recv_index);
+        }
     public:
         std::size_t rsize() const noexcept
         {
@@ -252,4 +287,30 @@ namespace lib {
             clear();
         }
     };
+
+    unittest {
+        CycleBuffer<int, 4> buffer;
+
+        check(buffer.rspan().empty());
+        buffer.send(1);
+        buffer.send(2);
+        buffer.send(3);
+        check(buffer.rspan().size() == 3);
+        check(buffer.front() == 1);
+        buffer.pop();
+        buffer.skip(buffer.rspan().size());
+        check(buffer.rsize() == 0);
+
+        // индексы: чтение 3, запись 3 -> данные переходят через конец массива
+        buffer.send(4);
+        buffer.send(5);
+        buffer.send(6);
+        auto first = buffer.rspan();
+        check(first.size() == 2 && first[0] == 4 && first[1] == 5);
+        buffer.skip(first.size());
+        auto second = buffer.rspan();
+        check(second.size() == 1 && second[0] == 6);
+        buffer.skip(second.size());
+        check(buffer.rsize() == 0 && buffer.wsize() == 4);
+    }
 }
@@ -1,14 +1,22 @@
 #pragma once
+#include <lib/test.hpp>
+#include <cstddef>
 #include <iterator>
+#include <new>
+#include <utility>
 
 
 namespace lib::data_structures {
 
-    template <class Tag = void>
+    /// Выравнивание узла по кэш-линии: соседние узлы, принадлежащие разным
+    /// потокам, не попадают в одну линию (false sharing).
+    constexpr inline std::size_t cache_line_alignment = std::hardware_destructive_interference_size;
+
+    template <class Tag = void, std::size_t Align = alignof(void*)>
     struct DLListElement;
 
     template <>
-    struct DLListElement<void>
+    struct DLListElement<void, alignof(void*)>
     {
         DLListElement* next = nullptr;
         DLListElement* prev = nullptr;
@@ -19,11 +27,15 @@ namespace lib::data_structures {
         DLListElement(DLListElement&& other) = delete;
     };
 
-    template <class Tag>
-    struct DLListElement: DLListElement<void>
+    /// Align больше естественного выравнивания заодно дополняет узел до кратного Align размера.
+    template <class Tag, std::size_t Align>
+    struct alignas(Align) DLListElement: DLListElement<void>
     {
     };
 
+    template <class Tag = void>
+    using AlignedDLListElement = DLListElement<Tag, cache_line_alignment>;
+
     inline void AddItemAfter(DLListElement<>& item, DLListElement<>* after) noexcept
     {
         item.prev = after;
@@ -73,6 +85,32 @@ namespace lib::data_structures {
         DLListElement<>* tail = nullptr;
 
     public:
+        DLList() noexcept = default;
+        DLList(const DLList&) = delete;
+        DLList& operator=(const DLList&) = delete;
+
+        DLList(DLList&& other) noexcept
+        : head(std::exchange(other.head, nullptr))
+        , tail(std::exchange(other.tail, nullptr))
+        {}
+
+        /// Элементы, которые были в списке, отцепляются от него и друг от друга.
+        DLList& operator=(DLList&& other) noexcept
+        {
+            if (this != &other) {
+                while (PopFront() != nullptr) {
+                }
+                head = std::exchange(other.head, nullptr);
+                tail = std::exchange(other.tail, nullptr);
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool Empty() const noexcept
+        {
+            return head == nullptr;
+        }
+
         void PushBack(DLListElement<>& item) noexcept
         {
             AddItemAfter(item, tail);
@@ -82,8 +120,8 @@ namespace lib::data_structures {
             }
         }
 
-        template <class Tag>
-        void PushBack(DLListElement<Tag>& item) noexcept
+        template <class Tag, std::size_t Align>
+        void PushBack(DLListElement<Tag, Align>& item) noexcept
         {
             PushBack(static_cast<DLListElement<>&>(item));
         }
@@ -97,12 +135,49 @@ namespace lib::data_structures {
             }
         }
 
-        template <class Tag>
-        void PushFront(DLListElement<Tag>& item) noexcept
+        template <class Tag, std::size_t Align>
+        void PushFront(DLListElement<Tag, Align>& item) noexcept
         {
             PushFront(static_cast<DLListElement<>&>(item));
         }
 
+        /// Снимает первый элемент; nullptr, если список пуст.
+        DLListElement<>* PopFront() noexcept
+        {
+            auto* item = head;
+            if (item != nullptr) {
+                head = item->next;
+                if (head == nullptr) {
+                    tail = nullptr;
+                }
+                RemoveItem(*item);
+            }
+            return item;
+        }
+
+        /// Переносит все элементы other в конец списка за O(1).
+        void Splice(DLList& other) noexcept
+        {
+            if (other.head == nullptr) {
+                return;
+            }
+            if (tail == nullptr) {
+                head = other.head;
+            } else {
+                tail->next = other.head;
+                other.head->prev = tail;
+            }
+            tail = other.tail;
+            other.head = nullptr;
+            other.tail = nullptr;
+        }
+
+        /// Забирает все элементы за O(1), список остаётся пустым.
+        [[nodiscard]] DLList StealAll() noexcept
+        {
+            return std::move(*this);
+        }
+
         template <class T>
         struct TRange
         {
@@ -185,4 +260,44 @@ namespace lib::data_structures {
         }
     };
 
-}
\ No newline at end of file
+    unittest {
+        struct Item: DLListElement<>
+        {
+            int value;
+            explicit Item(int value) noexcept
+            : value(value)
+            {}
+        };
+
+        Item items[] = {Item(0), Item(1), Item(2), Item(3)};
+        DLList first;
+        DLList second;
+        first.PushBack(items[0]);
+        first.PushBack(items[1]);
+        second.PushBack(items[2]);
+        second.PushBack(items[3]);
+
+        first.Splice(second);
+        check(second.Empty());
+        int expected = 0;
+        for (auto& item: first.Range<Item>()) {
+            check(item.value == expected++);
+        }
+        check(expected == 4);
+
+        auto stolen = first.StealAll();
+        check(first.Empty() && !stolen.Empty());
+        check(static_cast<Item*>(stolen.PopFront())->value == 0);
+        check(items[0].next == nullptr && items[1].prev == nullptr);
+
+        DLList target;
+        target.PushBack(items[0]);
+        target = std::move(stolen);
+        check(items[0].next == nullptr && items[0].prev == nullptr);
+        check(static_cast<Item*>(target.PopFront())->value == 1);
+        check(target.PopFront() == &items[2] && target.PopFront() == &items[3] && target.Empty());
+
+        static_assert(alignof(AlignedDLListElement<>) == cache_line_alignment);
+        static_assert(sizeof(AlignedDLListElement<>) == cache_line_alignment);
+    }
+}
@@ -0,0 +1,657 @@
+#pragma once
+#include <lib/typename.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define LIB_FLAT_HASH_MAP_SSE2 1
+#else
+#   define LIB_FLAT_HASH_MAP_SSE2 0
+#endif
+
+
+namespace lib::data_structures {
+
+    namespace details {
+        /// Управляющий байт ячейки: 0..127 - занята (7 младших бит хэша), иначе пуста или удалена.
+        enum Control: std::int8_t
+        {
+            Empty   = -128,
+            Deleted = -2,
+        };
+
+        /// Группа из 16 управляющих байт, проверяется за одну операцию.
+        struct Group
+        {
+            constexpr static inline std::size_t width = 16;
+
+#if LIB_FLAT_HASH_MAP_SSE2
+            __m128i ctrl;
+
+            explicit Group(const std::int8_t* pos) noexcept
+            : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+            {}
+
+            [[nodiscard]] std::uint32_t match(std::int8_t hash) const noexcept
+            {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), ctrl)));
+            }
+            [[nodiscard]] std::uint32_t match_empty() const noexcept
+            {
+                return match(Empty);
+            }
+            [[nodiscard]] std::uint32_t match_empty_or_deleted() const noexcept
+            {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+            }
+#else
+            std::int8_t ctrl[width];
+
+            explicit Group(const std::int8_t* pos) noexcept
+            {
+                std::memcpy(ctrl, pos, width);
+            }
+
+            [[nodiscard]] std::uint32_t match(std::int8_t hash) const noexcept
+            {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < width; ++i) {
+                    mask |= std::uint32_t(ctrl[i] == hash) << i;
+                }
+                return mask;
+            }
+            [[nodiscard]] std::uint32_t match_empty() const noexcept
+            {
+                return match(Empty);
+            }
+            [[nodiscard]] std::uint32_t match_empty_or_deleted() const noexcept
+            {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < width; ++i) {
+                    mask |= std::uint32_t(ctrl[i] < 0) << i;
+                }
+                return mask;
+            }
+#endif
+        };
+
+        template <class T>
+        concept Transparent = requires { typename T::is_transparent; };
+    }
+
+    /// Прозрачный хэш по умолчанию: std::string ищется и по std::string_view, и по const char*.
+    template <class Key>
+    struct FlatHash: std::hash<Key>
+    {};
+
+    template <>
+    struct FlatHash<std::string>
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view key) const noexcept
+        {
+            return std::hash<std::string_view>()(key);
+        }
+    };
+
+    /// Хэш-таблица с открытой адресацией в стиле Swiss table: ключи и значения
+    /// лежат в самой таблице, на каждую ячейку - управляющий байт. Поиск идёт
+    /// группами по 16 байт (SSE2), ёмкость - степень двойки, заполнение не выше 7/8.
+    /// Удаление оставляет надгробие, если без него оборвётся цепочка поиска.
+    /// Итераторы и ссылки становятся недействительными при росте таблицы.
+    /// Ключи хранятся константными и при росте копируются, значения - перемещаются.
+    template <class Key, class Value, class Hash = FlatHash<Key>, class KeyEqual = std::equal_to<>>
+    class FlatHashMap
+    {
+        using Group = details::Group;
+    public:
+        using key_type    = Key;
+        using mapped_type = Value;
+        using value_type  = std::pair<const Key, Value>;
+        using size_type   = std::size_t;
+        using hasher      = Hash;
+        using key_equal   = KeyEqual;
+
+        template <bool Const>
+        class Iterator
+        {
+            friend FlatHashMap;
+            template <bool>
+            friend class Iterator;
+
+            const std::int8_t*       ctrl = nullptr;
+            const std::int8_t*       last = nullptr;
+            FlatHashMap::value_type* slot = nullptr;
+
+            Iterator(const std::int8_t* ctrl, const std::int8_t* last, FlatHashMap::value_type* slot) noexcept
+            : ctrl(ctrl), last(last), slot(slot)
+            {}
+
+            void skip() noexcept
+            {
+                while (ctrl != last && *ctrl < 0) {
+                    ++ctrl;
+                    ++slot;
+                }
+            }
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = std::conditional_t<Const, const FlatHashMap::value_type, FlatHashMap::value_type>;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            Iterator() noexcept = default;
+            template <bool Mutable>
+            requires (Const && !Mutable)
+            Iterator(const Iterator<Mutable>& other) noexcept // NOLINT
+            : ctrl(other.ctrl), last(other.last), slot(other.slot)
+            {}
+
+            reference operator*() const noexcept
+            {
+                return *slot;
+            }
+            pointer operator->() const noexcept
+            {
+                return slot;
+            }
+            Iterator& operator++() noexcept
+            {
+                ++ctrl;
+                ++slot;
+                skip();
+                return *this;
+            }
+            Iterator operator++(int) noexcept
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+            friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept
+            {
+                return lhs.slot == rhs.slot;
+            }
+        };
+
+        using iterator       = Iterator<false>;
+        using const_iterator = Iterator<true>;
+    private:
+        constexpr static inline std::size_t min_capacity = Group::width;
+
+        std::int8_t* ctrl  = nullptr;
+        value_type*  slots = nullptr;
+        std::size_t  capacity_   = 0;
+        std::size_t  size_       = 0;
+        std::size_t  growth_left = 0;
+        [[no_unique_address]] Hash     hash_;
+        [[no_unique_address]] KeyEqual equal_;
+    public:
+        FlatHashMap() noexcept = default;
+        explicit FlatHashMap(std::size_t count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : hash_(hash), equal_(equal)
+        {
+            reserve(count);
+        }
+        FlatHashMap(std::initializer_list<value_type> values)
+        {
+            reserve(values.size());
+            for (const auto& value: values) {
+                insert(value);
+            }
+        }
+        FlatHashMap(const FlatHashMap& other)
+        : hash_(other.hash_), equal_(other.equal_)
+        {
+            reserve(other.size_);
+            for (const auto& value: other) {
+                insert_unique(hash(value.first), value);
+            }
+        }
+        FlatHashMap(FlatHashMap&& other) noexcept
+        : ctrl(std::exchange(other.ctrl, nullptr))
+        , slots(std::exchange(other.slots, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0))
+        , size_(std::exchange(other.size_, 0))
+        , growth_left(std::exchange(other.growth_left, 0))
+        , hash_(std::move(other.hash_))
+        , equal_(std::move(other.equal_))
+        {}
+        FlatHashMap& operator=(const FlatHashMap& other)
+        {
+            if (this != &other) {
+                *this = FlatHashMap(other);
+            }
+            return *this;
+        }
+        FlatHashMap& operator=(FlatHashMap&& other) noexcept
+        {
+            if (this != &other) {
+                destroy();
+                ctrl = std::exchange(other.ctrl, nullptr);
+                slots = std::exchange(other.slots, nullptr);
+                capacity_ = std::exchange(other.capacity_, 0);
+                size_ = std::exchange(other.size_, 0);
+                growth_left = std::exchange(other.growth_left, 0);
+                hash_ = std::move(other.hash_);
+                equal_ = std::move(other.equal_);
+            }
+            return *this;
+        }
+        ~FlatHashMap() noexcept
+        {
+            destroy();
+        }
+    public:
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return size_;
+        }
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+        [[nodiscard]] std::size_t capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        iterator begin() noexcept
+        {
+            iterator it(ctrl, ctrl + capacity_, slots);
+            it.skip();
+            return it;
+        }
+        iterator end() noexcept
+        {
+            return iterator(ctrl + capacity_, ctrl + capacity_, slots + capacity_);
+        }
+        const_iterator begin() const noexcept
+        {
+            return const_cast<FlatHashMap&>(*this).begin();
+        }
+        const_iterator end() const noexcept
+        {
+            return const_cast<FlatHashMap&>(*this).end();
+        }
+
+        /// Готовит таблицу к count элементам без перестроений.
+        void reserve(std::size_t count)
+        {
+            if (count > size_ + growth_left) {
+                resize(capacity_for(std::max(count, size_)));
+            }
+        }
+        void clear() noexcept
+        {
+            destroy();
+        }
+    public:
+        template <class K = Key>
+        [[nodiscard]] iterator find(const K& key) noexcept requires (std::is_same_v<K, Key> || (details::Transparent<Hash> && details::Transparent<KeyEqual>))
+        {
+            const auto index = lookup(key, hash(key));
+            return index == capacity_ ? end() : iterator_at(index);
+        }
+        template <class K = Key>
+        [[nodiscard]] const_iterator find(const K& key) const noexcept requires (std::is_same_v<K, Key> || (details::Transparent<Hash> && details::Transparent<KeyEqual>))
+        {
+            return const_cast<FlatHashMap&>(*this).find(key);
+        }
+        template <class K = Key>
+        [[nodiscard]] bool contains(const K& key) const noexcept requires (std::is_same_v<K, Key> || (details::Transparent<Hash> && details::Transparent<KeyEqual>))
+        {
+            return lookup(key, hash(key)) != capacity_;
+        }
+        template <class K = Key>
+        [[nodiscard]] Value& at(const K& key) requires (std::is_same_v<K, Key> || (details::Transparent<Hash> && details::Transparent<KeyEqual>))
+        {
+            const auto index = lookup(key, hash(key));
+            if (index == capacity_) {
+                throw std::out_of_range("FlatHashMap::at");
+            }
+            return slots[index].second;
+        }
+        template <class K = Key>
+        [[nodiscard]] const Value& at(const K& key) const requires (std::is_same_v<K, Key> || (details::Transparent<Hash> && details::Transparent<KeyEqual>))
+        {
+            return const_cast<FlatHashMap&>(*this).at(key);
+        }
+
+        template <class ...TArgs>
+        std::pair<iterator, bool> try_emplace(const Key& key, TArgs&& ...args)
+        {
+            return emplace_key(key, std::forward<TArgs>(args)...);
+        }
+        template <class ...TArgs>
+        std::pair<iterator, bool> try_emplace(Key&& key, TArgs&& ...args)
+        {
+            return emplace_key(std::move(key), std::forward<TArgs>(args)...);
+        }
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return emplace_key(value.first, value.second);
+        }
+        /// Ключ пары константный и копируется, перемещается только значение.
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return emplace_key(value.first, std::move(value.second));
+        }
+        template <class V>
+        std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value)
+        {
+            auto result = emplace_key(key, std::forward<V>(value));
+            if (!result.second) {
+                result.first->second = std::forward<V>(value);
+            }
+            return result;
+        }
+        Value& operator[](const Key& key)
+        {
+            return emplace_key(key).first->second;
+        }
+        Value& operator[](Key&& key)
+        {
+            return emplace_key(std::move(key)).first->second;
+        }
+
+        template <class K = Key>
+        std::size_t erase(const K& key) noexcept requires (std::is_same_v<K, Key> || (details::Transparent<Hash> && details::Transparent<KeyEqual>))
+        {
+            const auto index = lookup(key, hash(key));
+            if (index == capacity_) {
+                return 0;
+            }
+            erase_at(index);
+            return 1;
+        }
+        iterator erase(const_iterator position) noexcept
+        {
+            const auto index = static_cast<std::size_t>(position.slot - slots);
+            erase_at(index);
+            auto it = iterator_at(index);
+            it.skip();
+            return it;
+        }
+        iterator erase(iterator position) noexcept
+        {
+            return erase(const_iterator(position));
+        }
+    private:
+        /// std::hash для целых - тождество, поэтому хэш дополнительно перемешивается.
+        template <class K>
+        [[nodiscard]] std::size_t hash(const K& key) const noexcept
+        {
+            const auto value = static_cast<std::uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ULL;
+            return static_cast<std::size_t>(value ^ (value >> 32U));
+        }
+        constexpr static std::int8_t h2(std::size_t hash) noexcept
+        {
+            return static_cast<std::int8_t>(hash & 0x7FU);
+        }
+        constexpr static std::size_t h1(std::size_t hash) noexcept
+        {
+            return hash >> 7U;
+        }
+        constexpr static std::size_t max_load(std::size_t capacity) noexcept
+        {
+            return capacity - capacity / 8;
+        }
+        constexpr static std::size_t capacity_for(std::size_t count) noexcept
+        {
+            std::size_t capacity = min_capacity;
+            while (max_load(capacity) < count) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        iterator iterator_at(std::size_t index) noexcept
+        {
+            return iterator(ctrl + index, ctrl + capacity_, slots + index);
+        }
+
+        /// Индекс ячейки с ключом или capacity_, если ключа нет.
+        template <class K>
+        std::size_t lookup(const K& key, std::size_t hash) const noexcept
+        {
+            if (capacity_ == 0) {
+                return capacity_;
+            }
+            const auto mask = capacity_ - 1;
+            auto position = h1(hash) & mask;
+            for (std::size_t step = Group::width;; step += Group::width) {
+                const Group group(ctrl + position);
+                for (auto match = group.match(h2(hash)); match != 0; match &= match - 1) {
+                    const auto index = (position + std::countr_zero(match)) & mask;
+                    if (equal_(slots[index].first, key)) {
+                        return index;
+                    }
+                }
+                if (group.match_empty() != 0) {
+                    return capacity_;
+                }
+                position = (position + step) & mask;
+            }
+        }
+
+        /// Первая пустая или удалённая ячейка на пути поиска hash.
+        std::size_t free_slot(std::size_t hash) const noexcept
+        {
+            const auto mask = capacity_ - 1;
+            auto position = h1(hash) & mask;
+            for (std::size_t step = Group::width;; step += Group::width) {
+                const auto match = Group(ctrl + position).match_empty_or_deleted();
+                if (match != 0) {
+                    return (position + std::countr_zero(match)) & mask;
+                }
+                position = (position + step) & mask;
+            }
+        }
+
+        void set_ctrl(std::size_t index, std::int8_t value) noexcept
+        {
+            ctrl[index] = value;
+            if (index < Group::width - 1) {
+                ctrl[capacity_ + index] = value;
+            }
+        }
+
+        template <class K, class ...TArgs>
+        std::pair<iterator, bool> emplace_key(K&& key, TArgs&& ...args)
+        {
+            const auto hash = this->hash(key);
+            if (const auto index = lookup(key, hash); index != capacity_) {
+                return {iterator_at(index), false};
+            }
+            return {insert_unique(hash, std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<TArgs>(args)...)), true};
+        }
+
+        /// Вставка ключа, которого заведомо нет в таблице.
+        template <class ...TArgs>
+        iterator insert_unique(std::size_t hash, TArgs&& ...args)
+        {
+            if (capacity_ == 0) {
+                resize(min_capacity);
+            }
+            auto index = free_slot(hash);
+            if (growth_left == 0 && ctrl[index] != details::Deleted) {
+                // если больше половины занятого - надгробия, таблица только перестраивается
+                resize(size_ + 1 > max_load(capacity_) / 2 ? capacity_ * 2 : capacity_);
+                index = free_slot(hash);
+            }
+            new (slots + index) value_type(std::forward<TArgs>(args)...);
+            if (ctrl[index] == details::Empty) {
+                growth_left -= 1;
+            }
+            set_ctrl(index, h2(hash));
+            size_ += 1;
+            return iterator_at(index);
+        }
+
+        void erase_at(std::size_t index) noexcept
+        {
+            std::destroy_at(slots + index);
+            size_ -= 1;
+            // ячейку можно сделать пустой, если вокруг неё нет полной группы:
+            // тогда ни одна цепочка поиска не проходила через неё дальше
+            const auto mask = capacity_ - 1;
+            const auto after = Group(ctrl + index).match_empty();
+            const auto before = Group(ctrl + ((index - Group::width) & mask)).match_empty();
+            const bool never_full = after != 0 && before != 0
+                && std::countr_zero(after) + std::countl_zero(before << (32 - Group::width)) < int(Group::width);
+            if (never_full) {
+                set_ctrl(index, details::Empty);
+                growth_left += 1;
+            } else {
+                set_ctrl(index, details::Deleted);
+            }
+        }
+
+        void resize(std::size_t capacity)
+        {
+            auto* old_ctrl = ctrl;
+            auto* old_slots = slots;
+            const auto old_capacity = capacity_;
+
+            allocate(capacity);
+            for (std::size_t i = 0; i < old_capacity; ++i) {
+                if (old_ctrl[i] >= 0) {
+                    auto& value = old_slots[i];
+                    const auto hash = this->hash(value.first);
+                    const auto index = free_slot(hash);
+                    // ключ константный: копируется, как в insert(value_type&&); значение перемещается
+                    new (slots + index) value_type(std::move(value));
+                    std::destroy_at(&value);
+                    set_ctrl(index, h2(hash));
+                }
+            }
+            growth_left -= size_;
+            deallocate(old_ctrl, old_slots, old_capacity);
+        }
+
+        void allocate(std::size_t capacity)
+        {
+            auto slots_memory = std::allocator<value_type>().allocate(capacity);
+            try {
+                ctrl = new std::int8_t[capacity + Group::width - 1];
+            } catch (...) {
+                std::allocator<value_type>().deallocate(slots_memory, capacity);
+                throw;
+            }
+            slots = slots_memory;
+            std::memset(ctrl, details::Empty, capacity + Group::width - 1);
+            capacity_ = capacity;
+            growth_left = max_load(capacity);
+        }
+
+        static void deallocate(std::int8_t* ctrl, value_type* slots, std::size_t capacity) noexcept
+        {
+            if (capacity != 0) {
+                delete[] ctrl;
+                std::allocator<value_type>().deallocate(slots, capacity);
+            }
+        }
+
+        void destroy() noexcept
+        {
+            if constexpr (!std::is_trivially_destructible_v<value_type>) {
+                for (std::size_t i = 0; i < capacity_; ++i) {
+                    if (ctrl[i] >= 0) {
+                        std::destroy_at(slots + i);
+                    }
+                }
+            }
+            deallocate(ctrl, slots, capacity_);
+            ctrl = nullptr;
+            slots = nullptr;
+            capacity_ = size_ = growth_left = 0;
+        }
+    };
+
+    unittest {
+        FlatHashMap<int, int> map;
+        check(map.empty() && map.find(1) == map.end());
+
+        for (int i = 0; i < 1000; ++i) {
+            check(map.try_emplace(i, i * i).second);
+        }
+        check(!map.try_emplace(7, 0).second);
+        check(map.size() == 1000);
+        check(map.at(31) == 961);
+
+        for (int i = 0; i < 1000; i += 2) {
+            check(map.erase(i) == 1);
+        }
+        check(map.erase(0) == 0);
+        check(map.size() == 500);
+
+        bool found = true;
+        for (int i = 0; i < 1000; ++i) {
+            found = found && (map.contains(i) == (i % 2 == 1));
+        }
+        check(found);
+
+        long long sum = 0;
+        for (const auto& [key, value]: map) {
+            sum += key;
+        }
+        check(sum == 250000);
+
+        // перестроение после череды вставок и удалений не теряет элементы
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 1000; i += 2) {
+                map[i] = round;
+            }
+            for (int i = 0; i < 1000; i += 2) {
+                map.erase(i);
+            }
+        }
+        check(map.size() == 500 && map.capacity() <= 2048);
+
+        auto copy = map;
+        check(copy.size() == 500 && copy.at(999) == 999 * 999);
+    }
+
+    unittest {
+        FlatHashMap<std::string, int> map = {{"one", 1}, {"two", 2}};
+        map["three"] = 3;
+
+        check(map.find(std::string_view("two"))->second == 2);
+        check(map.contains("three"));
+        check(!map.contains(std::string_view("four")));
+
+        const auto before = map.capacity();
+        map.reserve(1000);
+        check(map.capacity() > before && map.size() == 3);
+        check(map.at("one") == 1);
+
+        auto it = map.erase(map.find("one"));
+        check(map.size() == 2 && !map.contains("one"));
+        (void)it;
+    }
+}
+
+namespace lib {
+    template <class Key, class Value, class Hash, class KeyEqual>
+    struct TypeName<data_structures::FlatHashMap<Key, Value, Hash, KeyEqual>>
+    {
+        constexpr static inline StaticString name = "lib::data_structures::FlatHashMap<" + type_name<Key> + ", " + type_name<Value> + ">";
+    };
+}
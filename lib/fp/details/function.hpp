@@ -195,8 +195,13 @@ namespace lib::fp::details {
     private:
         void emit(IExecutor* executor) const noexcept
         {
-            for (auto& subscriber: subscribers.Range<IAwaiter>()) {
-                subscriber.wakeup(executor);
+            data_structures::DLList ready;
+            {
+                std::lock_guard lock(mutex);
+                ready = subscribers.StealAll();
+            }
+            while (auto* subscriber = ready.PopFront()) {
+                static_cast<IAwaiter*>(subscriber)->wakeup(executor);
             }
         }
 
@@ -275,16 +280,19 @@ namespace lib::fp::details {
 
         void wakeup(IExecutor* executor) noexcept final
         {
-            std::lock_guard lock(mutex);
-            if (state == State::Prepare) {
-                if (++args_ready == sizeof...(TArgs)) {
-                    executor->add(this);
+            {
+                std::lock_guard lock(mutex);
+                if (state == State::Prepare) {
+                    if (++args_ready == sizeof...(TArgs)) {
+                        executor->add(this);
+                    }
+                }
+                if (state != State::Running) {
+                    return;
                 }
-            }
-            if (state == State::Running) {
                 state = State::Ready;
-                emit(executor);
             }
+            emit(executor);
         }
 
         template <std::size_t I>
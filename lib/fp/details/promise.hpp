@@ -3,7 +3,9 @@
 #include <lib/fp/details/result.hpp>
 
 #include <coroutine>
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
 
 
 namespace lib::fp::details {
@@ -29,9 +31,23 @@ namespace lib::fp::details {
         };
 
     private:
-        std::shared_ptr<CoroResult> result = std::make_shared<CoroResult>(this);
+        std::shared_ptr<CoroResult> result;
         mutable IExecutor* executor = nullptr;
 
+        /// Указатель на memory_resource хранится за кадром корутины.
+        constexpr static std::size_t frame_size(std::size_t size) noexcept
+        {
+            constexpr auto align = alignof(std::pmr::memory_resource*);
+            return (size + align - 1) / align * align + sizeof(std::pmr::memory_resource*);
+        }
+
+        static void* allocate(std::size_t size, std::pmr::memory_resource* memory)
+        {
+            auto* frame = static_cast<std::byte*>(memory->allocate(frame_size(size), alignof(std::max_align_t)));
+            new (frame + frame_size(size) - sizeof(memory)) std::pmr::memory_resource*(memory);
+            return frame;
+        }
+
     private:
         void run(IExecutor* executor) noexcept final
         {
@@ -44,6 +60,47 @@ namespace lib::fp::details {
             executor->add(this);
         }
 
+    public:
+        Promise()
+        : result(std::make_shared<CoroResult>(this))
+        {}
+
+        /// Корутина с параметрами (std::allocator_arg_t, std::pmr::memory_resource*, ...)
+        /// выделяет кадр и результат из переданного memory_resource.
+        template <class ...TArgs>
+        Promise(std::allocator_arg_t, std::pmr::memory_resource* memory, const TArgs& ...)
+        : result(std::allocate_shared<CoroResult>(std::pmr::polymorphic_allocator<CoroResult>(memory), this))
+        {}
+
+        template <class Class, class ...TArgs>
+        Promise(const Class&, std::allocator_arg_t, std::pmr::memory_resource* memory, const TArgs& ...)
+        : result(std::allocate_shared<CoroResult>(std::pmr::polymorphic_allocator<CoroResult>(memory), this))
+        {}
+
+        static void* operator new(std::size_t size)
+        {
+            return allocate(size, std::pmr::new_delete_resource());
+        }
+
+        template <class ...TArgs>
+        static void* operator new(std::size_t size, std::allocator_arg_t, std::pmr::memory_resource* memory, const TArgs& ...)
+        {
+            return allocate(size, memory);
+        }
+
+        template <class Class, class ...TArgs>
+        static void* operator new(std::size_t size, const Class&, std::allocator_arg_t, std::pmr::memory_resource* memory, const TArgs& ...)
+        {
+            return allocate(size, memory);
+        }
+
+        static void operator delete(void* frame, std::size_t size) noexcept
+        {
+            auto* memory = *std::launder(reinterpret_cast<std::pmr::memory_resource**>(
+                static_cast<std::byte*>(frame) + frame_size(size) - sizeof(std::pmr::memory_resource*)));
+            memory->deallocate(frame, frame_size(size), alignof(std::max_align_t));
+        }
+
     public:
         [[nodiscard]] Val<Type> get_return_object() const noexcept
         {
@@ -37,11 +37,17 @@ namespace lib::fp::details {
         mutable Mutex mutex;
 
     private:
+        /// Список подписчиков забирается под мьютексом, будятся они уже без него:
+        /// после смены state новые подписчики в список не попадают.
         void emit(IExecutor* executor) const noexcept
         {
-            std::lock_guard lock(mutex);
-            for (auto& subscriber: subscribers.Range<IAwaiter>()) {
-                subscriber.wakeup(executor);
+            data_structures::DLList ready;
+            {
+                std::lock_guard lock(mutex);
+                ready = subscribers.StealAll();
+            }
+            while (auto* subscriber = ready.PopFront()) {
+                static_cast<IAwaiter*>(subscriber)->wakeup(executor);
             }
         }
 
@@ -3,6 +3,8 @@
 #include <lib/fp/impl.function.hpp>
 #include <lib/fp/details/promise.hpp>
 
+#include <memory_resource>
+
 
 namespace lib::fp {
     template <class T, Signature<T> Signature>
@@ -38,6 +40,13 @@ namespace lib::fp {
         : result(std::make_shared<typename Fn<signature<T>, ImplFCall<std::remove_cvref_t<Function>>>::FunctionResult>(std::forward<Function>(function)))
         {}
 
+        template <class Function>
+        requires (!std::is_same_v<std::remove_cvref_t<Function>, Fn> && std::is_invocable_r_v<T, std::remove_cvref_t<Function>>)
+        Fn(std::allocator_arg_t, std::pmr::memory_resource* memory, Function&& function)
+        : result(std::allocate_shared<typename Fn<signature<T>, ImplFCall<std::remove_cvref_t<Function>>>::FunctionResult>(
+            std::pmr::polymorphic_allocator<>(memory), std::forward<Function>(function)))
+        {}
+
         template <class Function, class ...TArgs>
         Fn(const Fn<signature<T>, ImplFCall<Function, TArgs...>>& function) noexcept
         : result(function.result)
@@ -114,6 +123,19 @@ namespace lib::fp {
             const auto function = test_coro(test_coro());
             check(function(executor) == 43);
         }
+
+        inline Val<int> test_coro(std::allocator_arg_t, std::pmr::memory_resource*, int value)
+        {
+            co_return value;
+        }
+
+        unittest {
+            SimpleExecutor executor;
+            std::pmr::monotonic_buffer_resource memory;
+
+            const auto function = test_coro(std::allocator_arg, &memory, 7);
+            check(function(executor) == 7);
+        }
     }
 }
 
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+
+namespace lib::interpreter::bytecode {
+
+    using Register = std::uint8_t;
+    using Word = std::uint32_t;
+    using Value = std::uint64_t;
+
+    /// Команда - одно 32-битное слово: код операции и три байта аргументов a, b, c
+    /// либо a и 16-битный bx. Регистры адресуются относительно основания кадра.
+    enum class Op: std::uint8_t
+    {
+        Move,   // r[a] = r[b]
+        LoadI,  // r[a] = bx
+        LoadK,  // r[a] = constants[bx]
+        Add,    // r[a] = r[b] + r[c]
+        Trunc,  // r[a] &= (1 << 8*b) - 1
+        Call,   // r[a] = functions[bx](r[a], r[a + 1], ...), кадр вызываемой начинается с r[a]
+        Ret,    // вернуть r[a] в r[0] своего кадра
+        Count
+    };
+
+    constexpr Word encode(Op op, std::uint8_t a, std::uint8_t b = 0, std::uint8_t c = 0) noexcept
+    {
+        return Word(op) | (Word(a) << 8u) | (Word(b) << 16u) | (Word(c) << 24u);
+    }
+    constexpr Word encode_bx(Op op, std::uint8_t a, std::uint16_t bx) noexcept
+    {
+        return Word(op) | (Word(a) << 8u) | (Word(bx) << 16u);
+    }
+
+    constexpr Op op(Word word) noexcept
+    {
+        return static_cast<Op>(word & 0xFFu);
+    }
+    constexpr Register arg_a(Word word) noexcept
+    {
+        return static_cast<Register>(word >> 8u);
+    }
+    constexpr Register arg_b(Word word) noexcept
+    {
+        return static_cast<Register>(word >> 16u);
+    }
+    constexpr Register arg_c(Word word) noexcept
+    {
+        return static_cast<Register>(word >> 24u);
+    }
+    constexpr std::uint16_t arg_bx(Word word) noexcept
+    {
+        return static_cast<std::uint16_t>(word >> 16u);
+    }
+
+    struct Function
+    {
+        std::string name;
+        std::uint32_t entry = 0;
+        std::uint8_t params = 0;
+        std::uint8_t registers = 0;
+    };
+
+    struct Program
+    {
+        std::vector<Word> code;
+        std::vector<Value> constants;
+        std::vector<Function> functions;
+
+        /// Поиск точки входа по имени - один раз до исполнения, не на каждом вызове.
+        constexpr std::uint32_t find(std::string_view name) const
+        {
+            for (std::uint32_t i = 0; i < functions.size(); ++i) {
+                if (functions[i].name == name) {
+                    return i;
+                }
+            }
+            throw std::out_of_range("function not found");
+        }
+    };
+}
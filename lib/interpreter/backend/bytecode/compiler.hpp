@@ -0,0 +1,393 @@
+#pragma once
+#include <lib/interpreter/backend/bytecode/code.hpp>
+#include <lib/interpreter/ast.hpp>
+#include <lib/interpreter/symbol.hpp>
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+namespace lib::interpreter::bytecode {
+    namespace ast = lib::interpreter::ast;
+
+    struct TypeInfo
+    {
+        std::string_view name;
+        std::uint8_t     size;
+    };
+
+    constexpr inline std::array<TypeInfo, 5> types {
+        TypeInfo{"void", 0}, TypeInfo{"u8", 1}, TypeInfo{"u16", 2}, TypeInfo{"u32", 4}, TypeInfo{"u64", 8}
+    };
+
+    template <class T>
+    constexpr const TypeInfo& literal_type() noexcept
+    {
+        static_assert(std::is_unsigned_v<T> && sizeof(T) <= sizeof(Value));
+        for (const auto& type: types) {
+            if (type.size == sizeof(T)) {
+                return type;
+            }
+        }
+        return types[0];
+    }
+
+    /// Перевод модуля ast в байткод: имена переменных, типов и функций разрешаются
+    /// здесь в номера регистров и функций, в программе остаются только индексы.
+    /// Имена интернируются в SymbolTable, дальше сравниваются номера: области
+    /// видимости и перегрузки - массивы по номеру символа.
+    class Compiler
+    {
+        using TypeId = std::uint8_t;
+
+        constexpr static inline TypeId no_type = 0xFFu;
+        constexpr static inline std::uint32_t not_found = ~std::uint32_t(0);
+
+        struct Signature
+        {
+            Symbol name;
+            TypeId rtype;
+            std::vector<TypeId> params;
+            std::uint32_t next; // следующая перегрузка того же имени
+        };
+
+        struct Local
+        {
+            Symbol   name;
+            TypeId   type;
+            Register reg;
+            std::uint32_t shadowed; // внешнее объявление того же имени
+        };
+
+        Program program;
+        SymbolTable symbols;
+        SymbolIndex<TypeId, no_type> type_ids;
+        SymbolIndex<std::uint32_t, not_found> overloads;
+        SymbolIndex<std::uint32_t, not_found> scope;
+        std::vector<Signature> signatures;
+
+        std::vector<Local> locals;
+        TypeId rtype = 0;
+        std::uint32_t top = 0;
+        std::uint32_t max = 0;
+
+        Symbol sum_operator;
+    public:
+        constexpr Compiler()
+        {
+            for (TypeId id = 0; id < types.size(); ++id) {
+                type_ids.set(symbols.intern(types[id].name), id);
+            }
+            sum_operator = symbols.intern("operator: lhs + rhs");
+        }
+
+        template <class ...Statements>
+        constexpr Program operator()(const ast::Module<Statements...>& module)
+        {
+            std::apply([&](const auto& ...functions) { (declare(functions), ...); }, module.statements);
+            std::uint32_t index = 0;
+            std::apply([&](const auto& ...functions) { (define(index++, functions), ...); }, module.statements);
+            return std::move(program);
+        }
+    private:
+        template <class Name, class RType, class Parameters, class Body>
+        constexpr void declare(const ast::Function<Name, RType, Parameters, Body>& function)
+        {
+            if (signatures.size() > 0xFFFFu) {
+                throw std::length_error("too many functions");
+            }
+            const Symbol name = symbols.intern(function.name);
+            Signature signature{name, type_id(function.rtype), {}, overloads[name]};
+            for (const auto& param: function.params) {
+                signature.params.push_back(type_id(param.type));
+            }
+            overloads.set(name, static_cast<std::uint32_t>(signatures.size()));
+            signatures.push_back(std::move(signature));
+        }
+
+        template <class Name, class RType, class Parameters, class Body>
+        constexpr void define(std::uint32_t index, const ast::Function<Name, RType, Parameters, Body>& function)
+        {
+            const auto& signature = signatures[index];
+            top = 0;
+            max = 0;
+            rtype = signature.rtype;
+            std::uint32_t p = 0;
+            for (const auto& param: function.params) {
+                declare_local(symbols.intern(param.name), signature.params[p++]);
+            }
+
+            const std::uint32_t entry = program.code.size();
+            if (!body(function.body)) {
+                const Register zero = alloc();
+                emit(encode_bx(Op::LoadI, zero, 0));
+                emit(encode(Op::Ret, zero));
+            }
+            leave(0);
+            program.functions.push_back(Function{
+                std::string(symbols.name(signature.name)),
+                entry,
+                static_cast<std::uint8_t>(signature.params.size()),
+                static_cast<std::uint8_t>(max)
+            });
+        }
+
+        template <class Fn>
+        constexpr bool body(const ast::FunctorBody<Fn>&)
+        {
+            throw std::invalid_argument("native function body can not be compiled to bytecode");
+        }
+        template <class ...Operators>
+        constexpr bool body(const ast::Scope<Operators...>& scope)
+        {
+            return statement(scope);
+        }
+    private:
+        // statements
+        template <class ...Operators>
+        constexpr bool statement(const ast::Scope<Operators...>& scope)
+        {
+            const auto size = locals.size();
+            const auto saved = top;
+            bool returned = false;
+            std::apply([&](const auto& ...operators) { ((returned = statement(operators) || returned), ...); }, scope.operators);
+            leave(size);
+            top = saved;
+            return returned;
+        }
+
+        template <class InitExpression>
+        constexpr bool statement(const ast::VariableDeclaration<InitExpression>& vardecl)
+        {
+            const Register reg = alloc();
+            const TypeId type = expression(vardecl.init, reg);
+            --top;
+            declare_local(symbols.intern(vardecl.name), type);
+            return false;
+        }
+
+        template <class RValue>
+        constexpr bool statement(const ast::Return<RValue>& ret)
+        {
+            const auto saved = top;
+            if (types[rtype].size == 0 && types[type(ret.expression)].size != 0) {
+                throw std::invalid_argument("void function can not return a value");
+            }
+            if (types[type(ret.expression)].size > types[rtype].size) {
+                const Register reg = alloc();
+                expression(ret.expression, reg);
+                emit(encode(Op::Trunc, reg, types[rtype].size));
+                emit(encode(Op::Ret, reg));
+            } else {
+                emit(encode(Op::Ret, operand(ret.expression)));
+            }
+            top = saved;
+            return true;
+        }
+    private:
+        // types
+        template <class T>
+        constexpr TypeId type(const ast::Literal<T>&) const
+        {
+            return static_cast<TypeId>(&literal_type<T>() - types.data());
+        }
+        constexpr TypeId type(const ast::Variable& var) const
+        {
+            return local(var.name).type;
+        }
+        template <class Lhs, class Rhs>
+        constexpr TypeId type(const ast::Sum<Lhs, Rhs>& sum) const
+        {
+            const std::array ptypes = {type(sum.lhs), type(sum.rhs)};
+            if (const auto index = find_function(sum_operator, ptypes); index != not_found) {
+                return signatures[index].rtype;
+            }
+            return wider(ptypes[0], ptypes[1]);
+        }
+        template <class Name, class Params>
+        constexpr TypeId type(const ast::FunctionCall<Name, Params>& fcall) const
+        {
+            const auto ptypes = std::apply([&](const auto& ...params) {
+                return std::array<TypeId, sizeof...(params)>{type(params)...};
+            }, fcall.params);
+            return signatures[resolve(symbols.find(fcall.name), ptypes)].rtype;
+        }
+    private:
+        // expressions
+        template <class T>
+        constexpr TypeId expression(const ast::Literal<T>& literal, Register dst)
+        {
+            const Value value = literal.value;
+            if (value <= 0xFFFFu) {
+                emit(encode_bx(Op::LoadI, dst, static_cast<std::uint16_t>(value)));
+            } else {
+                emit(encode_bx(Op::LoadK, dst, constant(value)));
+            }
+            return type(literal);
+        }
+
+        constexpr TypeId expression(const ast::Variable& var, Register dst)
+        {
+            const auto& info = local(var.name);
+            if (info.reg != dst) {
+                emit(encode(Op::Move, dst, info.reg));
+            }
+            return info.type;
+        }
+
+        template <class Lhs, class Rhs>
+        constexpr TypeId expression(const ast::Sum<Lhs, Rhs>& sum, Register dst)
+        {
+            const std::array ptypes = {type(sum.lhs), type(sum.rhs)};
+            if (find_function(sum_operator, ptypes) != not_found) {
+                return call(sum_operator, std::tie(sum.lhs, sum.rhs), dst);
+            }
+            const TypeId result = wider(ptypes[0], ptypes[1]);
+            const auto saved = top;
+            const Register lhs = operand(sum.lhs);
+            const Register rhs = operand(sum.rhs);
+            emit(encode(Op::Add, dst, lhs, rhs));
+            if (types[result].size < sizeof(Value)) {
+                emit(encode(Op::Trunc, dst, types[result].size));
+            }
+            top = saved;
+            return result;
+        }
+
+        template <class Name, class Params>
+        constexpr TypeId expression(const ast::FunctionCall<Name, Params>& fcall, Register dst)
+        {
+            return call(symbols.find(fcall.name), fcall.params, dst);
+        }
+    private:
+        constexpr TypeId type_id(std::string_view name) const
+        {
+            const TypeId id = type_ids[symbols.find(name)];
+            if (id == no_type) {
+                throw std::out_of_range("type not found");
+            }
+            return id;
+        }
+
+        constexpr std::uint32_t find_function(Symbol name, lib::Span<const TypeId> ptypes) const
+        {
+            for (auto i = overloads[name]; i != not_found; i = signatures[i].next) {
+                const auto& params = signatures[i].params;
+                if (params.size() == ptypes.size() && std::equal(params.begin(), params.end(), ptypes.begin())) {
+                    return i;
+                }
+            }
+            return not_found;
+        }
+
+        constexpr std::uint32_t resolve(Symbol name, lib::Span<const TypeId> ptypes) const
+        {
+            const auto index = find_function(name, ptypes);
+            if (index == not_found) {
+                throw std::out_of_range("function not found");
+            }
+            return index;
+        }
+
+        constexpr const Local& local(std::string_view name) const
+        {
+            const auto index = scope[symbols.find(name)];
+            if (index == not_found) {
+                throw std::out_of_range("indentifier not found");
+            }
+            return locals[index];
+        }
+
+        constexpr void declare_local(Symbol name, TypeId type)
+        {
+            locals.push_back(Local{name, type, alloc(), scope[name]});
+            scope.set(name, static_cast<std::uint32_t>(locals.size() - 1));
+        }
+
+        constexpr void leave(std::size_t size)
+        {
+            while (locals.size() > size) {
+                scope.set(locals.back().name, locals.back().shadowed);
+                locals.pop_back();
+            }
+        }
+
+        constexpr static TypeId wider(TypeId lhs, TypeId rhs)
+        {
+            if (types[lhs].size == 0 || types[rhs].size == 0) {
+                throw std::invalid_argument("void operand");
+            }
+            return types[lhs].size < types[rhs].size ? rhs : lhs;
+        }
+
+        /// Аргументы кладутся в подряд идущие регистры, с первого из них начинается
+        /// кадр вызываемой функции, туда же она вернёт результат.
+        template <class Params>
+        constexpr TypeId call(Symbol name, const Params& params, Register dst)
+        {
+            constexpr std::uint32_t count = std::tuple_size_v<Params>;
+            const auto saved = top;
+            const Register base = dst + 1u == top ? dst : alloc();
+            while (top < base + std::max(count, 1u)) {
+                alloc();
+            }
+            std::uint32_t i = 0;
+            const auto ptypes = std::apply([&](const auto& ...args) {
+                return std::array<TypeId, count>{expression(args, static_cast<Register>(base + i++))...};
+            }, params);
+            const auto index = resolve(name, ptypes);
+            emit(encode_bx(Op::Call, base, static_cast<std::uint16_t>(index)));
+            if (base != dst) {
+                emit(encode(Op::Move, dst, base));
+            }
+            top = saved;
+            return signatures[index].rtype;
+        }
+
+        template <class Expression>
+        constexpr Register operand(const Expression& expr)
+        {
+            if constexpr (std::is_same_v<Expression, ast::Variable>) {
+                return local(expr.name).reg;
+            } else {
+                const Register reg = alloc();
+                expression(expr, reg);
+                return reg;
+            }
+        }
+
+        constexpr Register alloc()
+        {
+            // Function::registers хранит число регистров в одном байте
+            if (top >= 0xFFu) {
+                throw std::length_error("too many registers");
+            }
+            max = std::max(max, top + 1);
+            return static_cast<Register>(top++);
+        }
+
+        constexpr void emit(Word word)
+        {
+            program.code.push_back(word);
+        }
+
+        constexpr std::uint16_t constant(Value value)
+        {
+            for (std::uint32_t i = 0; i < program.constants.size(); ++i) {
+                if (program.constants[i] == value) {
+                    return static_cast<std::uint16_t>(i);
+                }
+            }
+            if (program.constants.size() > 0xFFFFu) {
+                throw std::length_error("too many constants");
+            }
+            program.constants.push_back(value);
+            return static_cast<std::uint16_t>(program.constants.size() - 1);
+        }
+    };
+
+    template <class ...Statements>
+    constexpr Program compile(const ast::Module<Statements...>& module)
+    {
+        return Compiler{}(module);
+    }
+}
@@ -0,0 +1,311 @@
+#pragma once
+#include <lib/interpreter/backend/bytecode/code.hpp>
+#include <algorithm>
+#include <array>
+#include <optional>
+
+namespace lib::interpreter::bytecode {
+
+    /// Проходы над байткодом между компилятором и машиной: встраивание маленьких
+    /// листовых функций, свёртка констант и удаление мёртвых записей. Код функций
+    /// линеен (переходов нет), так что анализ - один проход вперёд или назад.
+    /// Для constexpr модуля вся работа делается при компиляции программы на C++.
+    class Optimizer
+    {
+        struct Body
+        {
+            std::vector<Word> code;
+            std::uint32_t registers;
+        };
+
+        Program program;
+        std::vector<Body> bodies;
+        std::uint32_t inline_limit;
+    public:
+        constexpr explicit Optimizer(Program program, std::uint32_t inline_limit) noexcept
+        : program(std::move(program))
+        , inline_limit(inline_limit)
+        {}
+
+        constexpr Program operator()() &&
+        {
+            split();
+            // цепочки вызовов сворачиваются снизу вверх: после встраивания функция сама становится листом
+            for (std::uint32_t pass = 0; pass < 4; ++pass) {
+                bool changed = false;
+                for (auto& body: bodies) {
+                    changed = inline_calls(body) || changed;
+                }
+                if (!changed) {
+                    break;
+                }
+            }
+            for (auto& body: bodies) {
+                fold(body);
+                eliminate(body);
+            }
+            join();
+            return std::move(program);
+        }
+    private:
+        constexpr void split()
+        {
+            for (std::size_t i = 0; i < program.functions.size(); ++i) {
+                const auto& function = program.functions[i];
+                Body body{{}, function.registers};
+                for (auto pc = function.entry; pc < program.code.size(); ++pc) {
+                    body.code.push_back(program.code[pc]);
+                    if (op(program.code[pc]) == Op::Ret) {
+                        break; // дальше недостижимо
+                    }
+                }
+                bodies.push_back(std::move(body));
+            }
+        }
+
+        constexpr void join()
+        {
+            std::vector<Value> constants;
+            std::vector<std::uint32_t> remap(program.constants.size(), ~std::uint32_t(0));
+            program.code.clear();
+            for (std::size_t i = 0; i < bodies.size(); ++i) {
+                program.functions[i].entry = static_cast<std::uint32_t>(program.code.size());
+                program.functions[i].registers = static_cast<std::uint8_t>(bodies[i].registers);
+                for (Word word: bodies[i].code) {
+                    if (op(word) == Op::LoadK) {
+                        auto& index = remap[arg_bx(word)];
+                        if (index == ~std::uint32_t(0)) {
+                            index = static_cast<std::uint32_t>(constants.size());
+                            constants.push_back(program.constants[arg_bx(word)]);
+                        }
+                        word = encode_bx(Op::LoadK, arg_a(word), static_cast<std::uint16_t>(index));
+                    }
+                    program.code.push_back(word);
+                }
+            }
+            program.constants = std::move(constants);
+        }
+
+        constexpr bool leaf(const Body& body) const noexcept
+        {
+            for (Word word: body.code) {
+                if (op(word) == Op::Call) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Тело вызываемой подставляется со сдвигом регистров на основание кадра a,
+        /// Ret x превращается в Move a, a + x.
+        constexpr bool inline_calls(Body& body)
+        {
+            bool changed = false;
+            std::vector<Word> code;
+            for (Word word: body.code) {
+                if (op(word) != Op::Call) {
+                    code.push_back(word);
+                    continue;
+                }
+                const auto& callee = bodies[arg_bx(word)];
+                if (&callee == &body || !leaf(callee) || callee.code.size() > inline_limit
+                    || arg_a(word) + callee.registers > 0xFFu) {
+                    code.push_back(word);
+                    continue;
+                }
+                const Register base = arg_a(word);
+                for (Word inner: callee.code) {
+                    const auto a = static_cast<Register>(base + arg_a(inner));
+                    switch (op(inner)) {
+                    case Op::Move:
+                        code.push_back(encode(Op::Move, a, static_cast<Register>(base + arg_b(inner))));
+                        break;
+                    case Op::Add:
+                        code.push_back(encode(Op::Add, a,
+                            static_cast<Register>(base + arg_b(inner)), static_cast<Register>(base + arg_c(inner))));
+                        break;
+                    case Op::Trunc:
+                        code.push_back(encode(Op::Trunc, a, arg_b(inner)));
+                        break;
+                    case Op::LoadI:
+                    case Op::LoadK:
+                        code.push_back(encode_bx(op(inner), a, arg_bx(inner)));
+                        break;
+                    case Op::Ret:
+                        if (a != base) {
+                            code.push_back(encode(Op::Move, base, a));
+                        }
+                        break;
+                    default:
+                        throw std::logic_error("invalid opcode");
+                    }
+                }
+                body.registers = std::max<std::uint32_t>(body.registers, base + callee.registers);
+                changed = true;
+            }
+            body.code = std::move(code);
+            return changed;
+        }
+
+        constexpr Word load(Register reg, Value value)
+        {
+            if (value <= 0xFFFFu) {
+                return encode_bx(Op::LoadI, reg, static_cast<std::uint16_t>(value));
+            }
+            for (std::size_t i = 0; i < program.constants.size(); ++i) {
+                if (program.constants[i] == value) {
+                    return encode_bx(Op::LoadK, reg, static_cast<std::uint16_t>(i));
+                }
+            }
+            if (program.constants.size() > 0xFFFFu) {
+                throw std::length_error("too many constants");
+            }
+            program.constants.push_back(value);
+            return encode_bx(Op::LoadK, reg, static_cast<std::uint16_t>(program.constants.size() - 1));
+        }
+
+        /// Свёртка: значения регистров, известные до исполнения, протягиваются
+        /// вперёд, команды над ними заменяются загрузкой результата. Заодно
+        /// чтения копий (Move) заменяются чтением источника, а сами Move
+        /// остаются мёртвыми для eliminate.
+        constexpr void fold(Body& body)
+        {
+            constexpr std::uint32_t none = 0x100;
+            std::array<std::optional<Value>, 0x100> known;
+            std::array<std::uint32_t, 0x100> copy;
+            copy.fill(none);
+
+            const auto source = [&](Register reg) {
+                return copy[reg] == none ? reg : static_cast<Register>(copy[reg]);
+            };
+            const auto define = [&](std::uint32_t reg) {
+                copy[reg] = none;
+                for (auto& from: copy) {
+                    if (from == reg) {
+                        from = none;
+                    }
+                }
+            };
+
+            for (Word& word: body.code) {
+                const Register a = arg_a(word);
+                switch (op(word)) {
+                case Op::LoadI:
+                    known[a] = arg_bx(word);
+                    define(a);
+                    break;
+                case Op::LoadK:
+                    known[a] = program.constants[arg_bx(word)];
+                    define(a);
+                    break;
+                case Op::Move: {
+                    const Register b = source(arg_b(word));
+                    define(a);
+                    if ((known[a] = known[b])) {
+                        word = load(a, *known[a]);
+                    } else {
+                        word = encode(Op::Move, a, b);
+                        if (a != b) {
+                            copy[a] = b;
+                        }
+                    }
+                    break;
+                }
+                case Op::Add: {
+                    const Register b = source(arg_b(word));
+                    const Register c = source(arg_c(word));
+                    if (known[b] && known[c]) {
+                        known[a] = *known[b] + *known[c];
+                        word = load(a, *known[a]);
+                    } else {
+                        known[a].reset();
+                        word = encode(Op::Add, a, b, c);
+                    }
+                    define(a);
+                    break;
+                }
+                case Op::Trunc:
+                    if (known[a]) {
+                        // при ширине 0 сдвиг был бы на 64 бита
+                        const auto width = arg_b(word);
+                        known[a] = width == 0 ? Value(0) : width >= sizeof(Value) ? *known[a]
+                            : *known[a] & (~Value(0) >> (64u - 8u * width));
+                        word = load(a, *known[a]);
+                    }
+                    define(a);
+                    break;
+                case Op::Call:
+                    for (std::uint32_t r = a; r < known.size(); ++r) {
+                        known[r].reset();
+                        define(r);
+                    }
+                    break;
+                case Op::Ret:
+                    word = encode(Op::Ret, source(a));
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        /// Удаление записей в регистры, которые дальше не читаются.
+        constexpr void eliminate(Body& body)
+        {
+            std::array<bool, 0x100> live = {};
+            std::vector<bool> keep(body.code.size(), true);
+            for (auto i = body.code.size(); i-- > 0;) {
+                const Word word = body.code[i];
+                const Register a = arg_a(word);
+                switch (op(word)) {
+                case Op::Ret:
+                    live = {};
+                    live[a] = true;
+                    break;
+                case Op::Call: {
+                    const auto& callee = program.functions[arg_bx(word)];
+                    for (std::uint32_t r = a; r < a + bodies[arg_bx(word)].registers && r < live.size(); ++r) {
+                        live[r] = false;
+                    }
+                    for (std::uint32_t r = a; r < a + callee.params; ++r) {
+                        live[r] = true;
+                    }
+                    break;
+                }
+                case Op::Trunc:
+                    keep[i] = live[a];
+                    break;
+                default:
+                    if (op(word) == Op::Move && arg_b(word) == a) {
+                        keep[i] = false;
+                        break;
+                    }
+                    if (!(keep[i] = live[a])) {
+                        break;
+                    }
+                    live[a] = false;
+                    if (op(word) == Op::Move || op(word) == Op::Add) {
+                        live[arg_b(word)] = true;
+                    }
+                    if (op(word) == Op::Add) {
+                        live[arg_c(word)] = true;
+                    }
+                    break;
+                }
+            }
+            std::vector<Word> code;
+            for (std::size_t i = 0; i < body.code.size(); ++i) {
+                if (keep[i]) {
+                    code.push_back(body.code[i]);
+                }
+            }
+            body.code = std::move(code);
+        }
+    };
+
+    /// Функции не длиннее inline_limit команд без вызовов встраиваются в место вызова.
+    constexpr Program optimize(Program program, std::uint32_t inline_limit = 8)
+    {
+        return Optimizer(std::move(program), inline_limit)();
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <lib/interpreter/backend/bytecode/code.hpp>
+#include <lib/interpreter/trace.hpp>
+#include <type_traits>
+
+namespace lib::interpreter::bytecode {
+
+    /// Регистровая машина. Регистры и стек кадров переиспользуются между вызовами,
+    /// поэтому повторное исполнение не выделяет память и не ищет имён.
+    /// Tracer получает событие на каждую команду; NullTracer не стоит ничего.
+    template <class Tracer = NullTracer>
+    class BasicMachine
+    {
+        struct Frame
+        {
+            std::uint32_t pc;
+            std::uint32_t base;
+        };
+
+        std::vector<Value> registers;
+        std::vector<Frame> frames;
+        [[no_unique_address]] Tracer trace;
+    public:
+        constexpr BasicMachine() = default;
+        constexpr explicit BasicMachine(const Tracer& tracer)
+        : trace(tracer)
+        {}
+
+        constexpr Tracer& tracer() noexcept
+        {
+            return trace;
+        }
+        constexpr const Tracer& tracer() const noexcept
+        {
+            return trace;
+        }
+
+        template <class ...Args>
+        constexpr Value operator()(const Program& program, std::uint32_t function, const Args& ...args)
+        {
+            const auto& entry = program.functions[function];
+            if (sizeof...(Args) != entry.params) {
+                throw std::invalid_argument("wrong number of arguments");
+            }
+            reserve(0, entry.registers);
+            std::uint32_t i = 0;
+            ((registers[i++] = static_cast<Value>(args)), ...);
+            frames.clear();
+            if (std::is_constant_evaluated()) {
+                return run_switch(program, entry.entry);
+            }
+            return run(program, entry.entry);
+        }
+    private:
+        constexpr void step(Word word, std::uint32_t base)
+        {
+            if constexpr (Tracer::enabled) {
+                trace(TraceEvent{
+                    static_cast<std::uint8_t>(op(word)),
+                    base,
+                    op(word) == Op::Call ? arg_bx(word) : 0u
+                });
+            }
+        }
+
+        constexpr void reserve(std::uint32_t base, std::uint32_t count)
+        {
+            if (registers.size() < base + count) {
+                registers.resize(base + count);
+            }
+        }
+
+        constexpr Value run_switch(const Program& program, std::uint32_t pc)
+        {
+            const Word* code = program.code.data();
+            std::uint32_t base = 0;
+            for (;;) {
+                const Word word = code[pc++];
+                Value* r = registers.data() + base;
+                step(word, base);
+                switch (op(word)) {
+                case Op::Move:
+                    r[arg_a(word)] = r[arg_b(word)];
+                    break;
+                case Op::LoadI:
+                    r[arg_a(word)] = arg_bx(word);
+                    break;
+                case Op::LoadK:
+                    r[arg_a(word)] = program.constants[arg_bx(word)];
+                    break;
+                case Op::Add:
+                    r[arg_a(word)] = r[arg_b(word)] + r[arg_c(word)];
+                    break;
+                case Op::Trunc:
+                    r[arg_a(word)] &= ~Value(0) >> (64u - 8u * arg_b(word));
+                    break;
+                case Op::Call: {
+                    const auto& callee = program.functions[arg_bx(word)];
+                    frames.push_back(Frame{pc, base});
+                    base += arg_a(word);
+                    reserve(base, callee.registers);
+                    pc = callee.entry;
+                    break;
+                }
+                case Op::Ret: {
+                    const Value value = r[arg_a(word)];
+                    if (frames.empty()) {
+                        return value;
+                    }
+                    r[0] = value;
+                    pc = frames.back().pc;
+                    base = frames.back().base;
+                    frames.pop_back();
+                    break;
+                }
+                default:
+                    throw std::logic_error("invalid opcode");
+                }
+            }
+        }
+
+        Value run(const Program& program, std::uint32_t pc)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            static const void* const labels[] = {
+                &&move, &&loadi, &&loadk, &&add, &&trunc, &&call, &&ret
+            };
+            static_assert(std::size(labels) == std::size_t(Op::Count));
+
+            const Word* code = program.code.data();
+            Value* r = registers.data();
+            std::uint32_t base = 0;
+            Word word;
+
+#define LIB_BYTECODE_DISPATCH() word = code[pc++]; step(word, base); goto *labels[word & 0xFFu]
+            LIB_BYTECODE_DISPATCH();
+        move:
+            r[arg_a(word)] = r[arg_b(word)];
+            LIB_BYTECODE_DISPATCH();
+        loadi:
+            r[arg_a(word)] = arg_bx(word);
+            LIB_BYTECODE_DISPATCH();
+        loadk:
+            r[arg_a(word)] = program.constants[arg_bx(word)];
+            LIB_BYTECODE_DISPATCH();
+        add:
+            r[arg_a(word)] = r[arg_b(word)] + r[arg_c(word)];
+            LIB_BYTECODE_DISPATCH();
+        trunc:
+            r[arg_a(word)] &= ~Value(0) >> (64u - 8u * arg_b(word));
+            LIB_BYTECODE_DISPATCH();
+        call:
+            frames.push_back(Frame{pc, base});
+            base += arg_a(word);
+            reserve(base, program.functions[arg_bx(word)].registers);
+            r = registers.data() + base;
+            pc = program.functions[arg_bx(word)].entry;
+            LIB_BYTECODE_DISPATCH();
+        ret:
+            if (frames.empty()) {
+                return r[arg_a(word)];
+            }
+            r[0] = r[arg_a(word)];
+            pc = frames.back().pc;
+            base = frames.back().base;
+            frames.pop_back();
+            r = registers.data() + base;
+            LIB_BYTECODE_DISPATCH();
+#undef LIB_BYTECODE_DISPATCH
+#else
+            return run_switch(program, pc);
+#endif
+        }
+    };
+
+    using Machine = BasicMachine<>;
+}
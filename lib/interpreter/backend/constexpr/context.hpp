@@ -3,6 +3,7 @@
 #include <lib/interpreter/backend/constexpr/root.hpp>
 #include <lib/interpreter/backend/constexpr/typeinfo.hpp>
 #include <lib/interpreter/backend/constexpr/memory.hpp>
+#include <lib/interpreter/trace.hpp>
 #include <lib/lazy.string.hpp>
 
 namespace lib::interpreter::const_expr {
@@ -13,6 +14,11 @@ namespace lib::interpreter::const_expr {
         Pointer ptr = 0;
     };
 
+    enum class TraceOp: std::uint8_t
+    {
+        Push, Call, Return
+    };
+
     class Context;
 
     class FunctionPtr
@@ -64,6 +70,7 @@ namespace lib::interpreter::const_expr {
     {
         Context* parent;
         ScopeInfo scope;
+        TraceSink trace;
     public:
         Memory& memory;
     private:
@@ -121,6 +128,14 @@ namespace lib::interpreter::const_expr {
         constexpr Context(Context* parent, Memory& memory, ScopeInfo scope) noexcept
         : parent(parent)
         , scope(scope)
+        , trace(parent != nullptr ? parent->trace : TraceSink())
+        , memory(memory)
+        {}
+
+        constexpr Context(Memory& memory, ScopeInfo scope, TraceSink trace) noexcept
+        : parent(nullptr)
+        , scope(scope)
+        , trace(trace)
         , memory(memory)
         {}
 
@@ -138,6 +153,19 @@ namespace lib::interpreter::const_expr {
         {
             return get_variable(this, name).ptr;
         }
+    private:
+        /// Номер функции в таблице объявившей её области - только для трассировки.
+        constexpr std::uint32_t function_id(const FunctionInfo& function) const noexcept
+        {
+            for (auto ctx = this; ctx != nullptr; ctx = ctx->get_parent()) {
+                for (std::size_t i = 0; i < ctx->scope.functions.size(); ++i) {
+                    if (&ctx->scope.functions[i] == &function) {
+                        return static_cast<std::uint32_t>(i);
+                    }
+                }
+            }
+            return 0;
+        }
     public:
         // expressions
         template <class Lhs, class Rhs>
@@ -177,7 +205,7 @@ namespace lib::interpreter::const_expr {
         constexpr TypeInfo operator()(const ast::Literal<T>& literal, Pointer& sp)
         {
             using Type = TypeTrait<T>;
-            std::cout << "push[" << (sp - Type::size) << "]: " << literal.value << std::endl;
+            trace(TraceEvent{std::uint8_t(TraceOp::Push), sp - Type::size, 0});
             Type::save(memory, sp -= Type::size, literal.value);
             return get_type(this, Type::name);
         }
@@ -223,7 +251,9 @@ namespace lib::interpreter::const_expr {
             };
 
             Context context(this, memory, ScopeInfo{{}, args, {}});
-            std::cout << "function call[" << sp << "]: " << fcall.name << std::endl;
+            if (trace) {
+                trace(TraceEvent{std::uint8_t(TraceOp::Call), sp, function_id(function)});
+            }
             function.ptr(context, ptr);
 
             return get_type(this, function.rtype);
@@ -240,7 +270,7 @@ namespace lib::interpreter::const_expr {
         constexpr bool operator()(const ast::Return<RValue>& ret, Pointer& sp)
         {
             auto typeinfo = ret.expression(*this, sp);
-            std::cout << "return: " << sp << std::endl;
+            trace(TraceEvent{std::uint8_t(TraceOp::Return), sp, 0});
             const auto name = typeinfo.name + lib::string("::constructor");
             fn(name)(literal((*this)["return::value"]), literal(sp))(*this, sp);
             return true;
@@ -327,7 +357,8 @@ namespace lib::interpreter::const_expr {
 
         auto functions = import_functions(module);
         std::array types {
-            TypeInfo {"void", 0}, TypeInfo {"u32", 4}
+            TypeInfo {"void", 0}, TypeInfo {"u8", 1}, TypeInfo {"u16", 2}, TypeInfo {"u32", 4},
+            TypeInfo {"u64", 8}, TypeInfo {"f32", 4}
         };
         Context context(nullptr, memory, ScopeInfo{functions, {}, types});
 
@@ -1,47 +1,170 @@
 #pragma once
 #include <lib/array.hpp>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <new>
 
 namespace lib::interpreter::const_expr {
 
+    struct HeapStats
+    {
+        std::uint32_t used = 0;         // занято блоками
+        std::uint32_t requested = 0;    // из них запрошено
+        std::uint32_t free = 0;
+        std::uint32_t largest_free = 0;
+
+        /// Доля свободной памяти, недоступной одним блоком: 0 - свободное цельно.
+        constexpr double fragmentation() const noexcept
+        {
+            return free == 0 ? 0.0 : 1.0 - double(largest_free) / double(free);
+        }
+    };
+
+    /// Buddy-аллокатор адресов [0, Size). Блок порядка k - minsize << k байт.
+    /// Свободные блоки каждого порядка - битовая карта с картой-сводкой непустых
+    /// слов, поиск идёт по словам через countr_zero. alloc и free - O(log Size)
+    /// расщеплений/слияний. Size не обязан быть степенью двойки.
     template <std::size_t Size>
-    struct Heap
+    class Heap
     {
+    public:
         constexpr static inline std::uint32_t size = Size;
         constexpr static inline std::uint32_t minsize = 4;
-        constexpr static inline std::uint32_t hbits = size / minsize;
-        constexpr static inline std::uint32_t hmask = hbits / 64u + (hbits % 64u ? 1u : 0u);
+        constexpr static inline std::uint32_t blocks = size / minsize;
+        constexpr static inline std::uint32_t orders = std::bit_width(blocks);
 
-        std::array<std::uint64_t, hmask> heap = {0};
+        static_assert(blocks > 0 && size % minsize == 0);
+    private:
+        constexpr static inline std::uint32_t npos = ~std::uint32_t(0);
 
-        constexpr std::uint32_t alloc(std::uint32_t size)
+        struct Layout
+        {
+            std::array<std::uint32_t, orders + 1> bits = {};
+            std::array<std::uint32_t, orders + 1> summary = {};
+        };
+
+        constexpr static inline Layout layout = [] {
+            Layout layout;
+            for (std::uint32_t order = 0; order < orders; ++order) {
+                const std::uint32_t words = ((blocks >> order) + 63) / 64;
+                layout.bits[order + 1] = layout.bits[order] + words;
+                layout.summary[order + 1] = layout.summary[order] + (words + 63) / 64;
+            }
+            return layout;
+        }();
+
+        std::array<std::uint64_t, layout.bits[orders]> bits = {};
+        std::array<std::uint64_t, layout.summary[orders]> summary = {};
+        std::uint32_t used = 0;
+        std::uint32_t requested = 0;
+    public:
+        constexpr Heap() noexcept
         {
-            const std::uint32_t allocated_bits = size / minsize + (size % minsize ? 1u : 0u);
-            for (std::uint32_t i = 0, j = 0; i < hbits; ++i) {
-                if (heap[i / 64] & (std::uint64_t(1) << (i % 64))) {
-                    j = 0;
-                } else {
-                    j += 1;
+            // наибольшие выровненные блоки, покрывающие [0, blocks)
+            for (std::uint32_t block = 0; block < blocks;) {
+                std::uint32_t order = orders - 1;
+                while (block % (1u << order) != 0 || block + (1u << order) > blocks) {
+                    --order;
                 }
-                if (j == allocated_bits) {
-                    const std::uint32_t start = i - allocated_bits + 1;
-                    const std::uint32_t end = i + 1;
-                    for (j = start; j < end; j++) {
-                        heap[j / 64] |= (std::uint64_t(1) << (j % 64));
-                    }
-                    return start * minsize;
+                set(order, block >> order);
+                block += 1u << order;
+            }
+        }
+
+        constexpr std::uint32_t alloc(std::uint32_t size)
+        {
+            const std::uint32_t order = order_of(size);
+            std::uint32_t from = order;
+            std::uint32_t block = npos;
+            for (; from < orders; ++from) {
+                if ((block = find(from)) != npos) {
+                    break;
                 }
             }
-            throw std::bad_alloc();
+            if (block == npos) {
+                throw std::bad_alloc();
+            }
+            clear(from, block);
+            for (; from > order; --from) {
+                block <<= 1;
+                set(from - 1, block | 1u);
+            }
+            used += minsize << order;
+            requested += size;
+            return block * (minsize << order);
         }
 
         constexpr void free(std::uint32_t ptr, std::uint32_t size)
         {
-            const std::uint32_t allocated_bits = size / minsize + (size % minsize ? 1u : 0u);
-            const std::uint32_t start = ptr / minsize;
-            const std::uint32_t end = start + allocated_bits;
-            for (std::uint32_t i = start; i < end; i++) {
-                heap[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+            std::uint32_t order = order_of(size);
+            std::uint32_t block = ptr / (minsize << order);
+            used -= minsize << order;
+            requested -= size;
+            for (; order + 1 < orders; ++order) {
+                const std::uint32_t buddy = block ^ 1u;
+                if (buddy >= (blocks >> order) || !test(order, buddy)) {
+                    break;
+                }
+                clear(order, buddy);
+                block >>= 1;
+            }
+            set(order, block);
+        }
+
+        constexpr HeapStats stats() const noexcept
+        {
+            HeapStats stats{used, requested, blocks * minsize - used, 0};
+            for (std::uint32_t order = orders; order > 0; --order) {
+                if (find(order - 1) != npos) {
+                    stats.largest_free = minsize << (order - 1);
+                    break;
+                }
+            }
+            return stats;
+        }
+    private:
+        constexpr static std::uint32_t order_of(std::uint32_t size)
+        {
+            const std::uint32_t count = size <= minsize ? 1u : (size + minsize - 1) / minsize;
+            const std::uint32_t order = std::bit_width(count - 1);
+            if (order >= orders) {
+                throw std::bad_alloc();
+            }
+            return order;
+        }
+
+        constexpr bool test(std::uint32_t order, std::uint32_t block) const noexcept
+        {
+            return bits[layout.bits[order] + block / 64] & (std::uint64_t(1) << (block % 64));
+        }
+
+        constexpr void set(std::uint32_t order, std::uint32_t block) noexcept
+        {
+            const std::uint32_t word = block / 64;
+            bits[layout.bits[order] + word] |= std::uint64_t(1) << (block % 64);
+            summary[layout.summary[order] + word / 64] |= std::uint64_t(1) << (word % 64);
+        }
+
+        constexpr void clear(std::uint32_t order, std::uint32_t block) noexcept
+        {
+            const std::uint32_t word = block / 64;
+            auto& bitmap = bits[layout.bits[order] + word];
+            bitmap &= ~(std::uint64_t(1) << (block % 64));
+            if (bitmap == 0) {
+                summary[layout.summary[order] + word / 64] &= ~(std::uint64_t(1) << (word % 64));
+            }
+        }
+
+        constexpr std::uint32_t find(std::uint32_t order) const noexcept
+        {
+            for (std::uint32_t s = layout.summary[order]; s < layout.summary[order + 1]; ++s) {
+                if (summary[s] != 0) {
+                    const std::uint32_t word = (s - layout.summary[order]) * 64 + std::countr_zero(summary[s]);
+                    return word * 64 + std::countr_zero(bits[layout.bits[order] + word]);
+                }
             }
+            return npos;
         }
     };
 }
@@ -1,68 +1,137 @@
 #pragma once
-#include <lib/tag.hpp>
+#include <lib/typetraits/tag.hpp>
 #include <lib/array.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace lib::interpreter::const_expr {
 
+    template <class T>
+    constexpr inline bool is_span = false;
+    template <class T>
+    constexpr inline bool is_span<lib::Span<T>> = true;
+
+    /// Байтовая область для push: Span<std::uint8_t> или Span<const std::uint8_t>.
+    template <class T>
+    using RequireRegion = lib::Require<std::is_same_v<std::remove_const_t<T>, std::uint8_t>>;
+
+    /// Память интерпретатора. Скаляры хранятся в little-endian независимо от
+    /// платформы. Вне константного вычисления load/save - один memcpy.
     class Memory
     {
-        lib::span<std::uint8_t> storage;
+        lib::Span<std::uint8_t> storage;
+
+        template <class T>
+        using Bytes = std::array<std::uint8_t, sizeof(T)>;
+
+        template <class T>
+        constexpr static Bytes<T> little_endian(Bytes<T> bytes) noexcept
+        {
+            if constexpr (std::endian::native == std::endian::big && std::is_arithmetic_v<T>) {
+                std::reverse(bytes.begin(), bytes.end());
+            }
+            return bytes;
+        }
     public:
-        constexpr Memory(lib::span<std::uint8_t> storage) noexcept
+        constexpr Memory(lib::Span<std::uint8_t> storage) noexcept
         : storage(storage)
         {}
 
-        constexpr std::uint8_t load(std::uint32_t ptr, lib::tag_t<std::uint8_t>) const
-        {
-            return storage[ptr];
-        }
-        constexpr void save(std::uint32_t ptr, std::uint8_t value)
+        constexpr std::size_t size() const noexcept
         {
-            storage[ptr] = value;
+            return storage.size();
         }
 
-        constexpr std::uint16_t load(std::uint32_t ptr, lib::tag_t<std::uint16_t>) const
-        {
-            std::uint16_t value = 0;
-            value |= (static_cast<std::uint16_t>(storage[ptr + 0]) << 0u);
-            value |= (static_cast<std::uint16_t>(storage[ptr + 1]) << 8u);
-            return value;
-        }
-        constexpr void save(std::uint32_t ptr, std::uint16_t value)
+        template <class T>
+        constexpr T load(std::uint32_t ptr, lib::typetraits::TTag<T> = {}) const
         {
-            storage[ptr + 0] = static_cast<std::uint8_t>(value >> 0u);
-            storage[ptr + 1] = static_cast<std::uint8_t>(value >> 8u);
+            static_assert(std::is_trivially_copyable_v<T> && !is_span<T>);
+            Bytes<T> bytes;
+            if (std::is_constant_evaluated()) {
+                for (std::size_t i = 0; i < sizeof(T); ++i) {
+                    bytes[i] = storage[ptr + i];
+                }
+            } else {
+                std::memcpy(bytes.data(), storage.data() + ptr, sizeof(T));
+            }
+            return std::bit_cast<T>(little_endian<T>(bytes));
         }
 
-        constexpr std::uint32_t load(std::uint32_t ptr, lib::tag_t<std::uint32_t>) const
+        template <class T>
+        constexpr void save(std::uint32_t ptr, const T& value)
         {
-            std::uint32_t value = 0;
-            value |= (static_cast<std::uint16_t>(storage[ptr + 0]) << 0u);
-            value |= (static_cast<std::uint16_t>(storage[ptr + 1]) << 8u);
-            value |= (static_cast<std::uint16_t>(storage[ptr + 2]) << 16u);
-            value |= (static_cast<std::uint16_t>(storage[ptr + 3]) << 24u);
-            return value;
+            static_assert(std::is_trivially_copyable_v<T> && !is_span<T>, "regions go through push/pop");
+            const auto bytes = little_endian<T>(std::bit_cast<Bytes<T>>(value));
+            if (std::is_constant_evaluated()) {
+                for (std::size_t i = 0; i < sizeof(T); ++i) {
+                    storage[ptr + i] = bytes[i];
+                }
+            } else {
+                std::memcpy(storage.data() + ptr, bytes.data(), sizeof(T));
+            }
         }
-        constexpr void save(std::uint32_t ptr, std::uint32_t value)
+
+        /// Перенос области размером size, области могут перекрываться.
+        constexpr void copy(std::uint32_t dst, std::uint32_t src, std::uint32_t size)
         {
-            storage[ptr + 0] = static_cast<std::uint8_t>(value >> 0u);
-            storage[ptr + 1] = static_cast<std::uint8_t>(value >> 8u);
-            storage[ptr + 2] = static_cast<std::uint8_t>(value >> 16u);
-            storage[ptr + 3] = static_cast<std::uint8_t>(value >> 24u);
+            if (std::is_constant_evaluated()) {
+                if (dst < src) {
+                    for (std::uint32_t i = 0; i < size; ++i) {
+                        storage[dst + i] = storage[src + i];
+                    }
+                } else {
+                    for (std::uint32_t i = size; i > 0; --i) {
+                        storage[dst + i - 1] = storage[src + i - 1];
+                    }
+                }
+            } else if (size != 0) {
+                std::memmove(storage.data() + dst, storage.data() + src, size);
+            }
         }
 
         template <class T>
-        constexpr T pop(std::uint32_t& sp, lib::tag_t<T> tag) const
+        constexpr T pop(std::uint32_t& sp, lib::typetraits::TTag<T> tag = {}) const
         {
             auto val = load(sp, tag);
             sp += sizeof(T);
             return val;
         }
         template <class T>
-        constexpr void push(std::uint32_t& sp, T value)
+        constexpr void push(std::uint32_t& sp, const T& value)
         {
             save(sp - sizeof(T), value);
             sp -= sizeof(T);
         }
+
+        /// Кладёт на стек область целиком, например аргументы вызова.
+        /// Шаблон, чтобы Span<std::uint8_t> не уходил в push скаляра.
+        template <class U, typename = RequireRegion<U>>
+        constexpr void push(std::uint32_t& sp, lib::Span<U> region)
+        {
+            sp -= region.size();
+            if (std::is_constant_evaluated()) {
+                for (std::size_t i = 0; i < region.size(); ++i) {
+                    storage[sp + i] = region[i];
+                }
+            } else if (!region.empty()) {
+                std::memcpy(storage.data() + sp, region.data(), region.size());
+            }
+        }
+        template <class U, typename = lib::Require<std::is_same_v<U, std::uint8_t>>>
+        constexpr void pop(std::uint32_t& sp, lib::Span<U> region) const
+        {
+            if (std::is_constant_evaluated()) {
+                for (std::size_t i = 0; i < region.size(); ++i) {
+                    region[i] = storage[sp + i];
+                }
+            } else if (!region.empty()) {
+                std::memcpy(region.data(), storage.data() + sp, region.size());
+            }
+            sp += region.size();
+        }
     };
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <lib/interpreter/backend/constexpr/root.hpp>
+#include <lib/typetraits/tag.hpp>
 #include <lib/static.string.hpp>
 
 namespace lib::interpreter::const_expr {
@@ -7,16 +8,45 @@ namespace lib::interpreter::const_expr {
     template <class T>
     struct TypeTrait;
 
-    template <>
-    struct TypeTrait<std::uint32_t>
+    template <class T>
+    struct ScalarTypeTrait
     {
-        constexpr static inline auto name = lib::StaticString("u32");
-        constexpr static inline auto size = sizeof(std::uint32_t);
-        constexpr static inline auto save = [](auto& memory, Pointer sp, std::uint32_t value) {
+        constexpr static inline auto size = sizeof(T);
+        constexpr static inline auto save = [](auto& memory, Pointer sp, T value) {
             memory.save(sp, value);
         };
         constexpr static inline auto load = [](auto& memory, Pointer sp) {
-            return memory.load(sp);
+            return memory.load(sp, lib::typetraits::tag_t<T>);
         };
     };
+
+    template <>
+    struct TypeTrait<std::uint8_t>: ScalarTypeTrait<std::uint8_t>
+    {
+        constexpr static inline auto name = lib::StaticString("u8");
+    };
+
+    template <>
+    struct TypeTrait<std::uint16_t>: ScalarTypeTrait<std::uint16_t>
+    {
+        constexpr static inline auto name = lib::StaticString("u16");
+    };
+
+    template <>
+    struct TypeTrait<std::uint32_t>: ScalarTypeTrait<std::uint32_t>
+    {
+        constexpr static inline auto name = lib::StaticString("u32");
+    };
+
+    template <>
+    struct TypeTrait<std::uint64_t>: ScalarTypeTrait<std::uint64_t>
+    {
+        constexpr static inline auto name = lib::StaticString("u64");
+    };
+
+    template <>
+    struct TypeTrait<float>: ScalarTypeTrait<float>
+    {
+        constexpr static inline auto name = lib::StaticString("f32");
+    };
 }
@@ -0,0 +1,4 @@
+#pragma once
+#include <lib/interpreter/backend/bytecode/compiler.hpp>
+#include <lib/interpreter/backend/bytecode/vm.hpp>
+#include <lib/interpreter/backend/bytecode/optimize.hpp>
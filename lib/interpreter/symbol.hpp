@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace lib::interpreter {
+
+    using Symbol = std::uint32_t;
+
+    constexpr inline Symbol no_symbol = ~Symbol(0);
+
+    /// Интернирование имён: каждому различному имени - плотный номер с нуля.
+    /// Дальше имена сравниваются как целые, а таблицы областей видимости
+    /// индексируются номером. Строки не копируются - они должны жить дольше таблицы.
+    class SymbolTable
+    {
+        std::vector<std::string_view> names;
+        std::vector<Symbol> slots; // открытая адресация, no_symbol - пусто
+    public:
+        constexpr Symbol intern(std::string_view name)
+        {
+            if ((names.size() + 1) * 2 > slots.size()) {
+                rehash(slots.empty() ? 16 : slots.size() * 2);
+            }
+            auto slot = lookup(name);
+            if (slots[slot] == no_symbol) {
+                slots[slot] = static_cast<Symbol>(names.size());
+                names.push_back(name);
+            }
+            return slots[slot];
+        }
+
+        constexpr Symbol find(std::string_view name) const noexcept
+        {
+            return slots.empty() ? no_symbol : slots[lookup(name)];
+        }
+
+        constexpr std::string_view name(Symbol symbol) const noexcept
+        {
+            return names[symbol];
+        }
+
+        constexpr std::size_t size() const noexcept
+        {
+            return names.size();
+        }
+    private:
+        constexpr static std::size_t hash(std::string_view name) noexcept
+        {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (const char c: name) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+            return static_cast<std::size_t>(hash ^ (hash >> 32u));
+        }
+
+        constexpr std::size_t lookup(std::string_view name) const noexcept
+        {
+            const auto mask = slots.size() - 1;
+            for (auto slot = hash(name) & mask;; slot = (slot + 1) & mask) {
+                if (slots[slot] == no_symbol || names[slots[slot]] == name) {
+                    return slot;
+                }
+            }
+        }
+
+        constexpr void rehash(std::size_t capacity)
+        {
+            slots.assign(capacity, no_symbol);
+            for (Symbol symbol = 0; symbol < names.size(); ++symbol) {
+                slots[lookup(names[symbol])] = symbol;
+            }
+        }
+    };
+
+    /// Отображение Symbol -> T: номера плотные, так что это просто массив.
+    template <class T, T Empty>
+    class SymbolIndex
+    {
+        std::vector<T> values;
+    public:
+        constexpr T operator[](Symbol symbol) const noexcept
+        {
+            return symbol < values.size() ? values[symbol] : Empty;
+        }
+
+        constexpr void set(Symbol symbol, T value)
+        {
+            if (symbol >= values.size()) {
+                values.resize(symbol + 1, Empty);
+            }
+            values[symbol] = value;
+        }
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <lib/concept.hpp>
+
+namespace lib::interpreter {
+
+    /// Шаг исполнения. opcode - код операции бэкенда (bytecode::Op,
+    /// const_expr::TraceOp), sp - указатель стека или основание кадра,
+    /// callee - номер вызываемой функции для вызовов.
+    struct TraceEvent
+    {
+        std::uint8_t  opcode = 0;
+        std::uint32_t sp = 0;
+        std::uint32_t callee = 0;
+    };
+
+    /// Трассировщик по умолчанию: enabled == false, вызовы отбрасываются при компиляции.
+    struct NullTracer
+    {
+        constexpr static inline bool enabled = false;
+
+        constexpr void operator()(const TraceEvent&) const noexcept
+        {}
+    };
+
+    /// Последние Size событий в кольцевом буфере, без выделений памяти.
+    template <std::size_t Size>
+    class RingTracer
+    {
+        static_assert(Size > 0);
+
+        std::array<TraceEvent, Size> events = {};
+        std::uint64_t total = 0;
+    public:
+        constexpr static inline bool enabled = true;
+
+        constexpr void operator()(const TraceEvent& event) noexcept
+        {
+            events[total % Size] = event;
+            ++total;
+        }
+
+        /// i-е из сохранённых событий, от старого к новому.
+        constexpr const TraceEvent& operator[](std::size_t i) const noexcept
+        {
+            return events[(total - size() + i) % Size];
+        }
+
+        constexpr std::size_t size() const noexcept
+        {
+            return total < Size ? static_cast<std::size_t>(total) : Size;
+        }
+
+        /// Сколько событий было всего, включая вытесненные.
+        constexpr std::uint64_t count() const noexcept
+        {
+            return total;
+        }
+
+        constexpr void clear() noexcept
+        {
+            total = 0;
+        }
+    };
+
+    /// Ссылка на трассировщик со стёртым типом, для кода, который не шаблонен
+    /// по трассировщику. Пустая - одна проверка на событие.
+    class TraceSink
+    {
+        void* self = nullptr;
+        void (*sink)(void*, const TraceEvent&) = nullptr;
+    public:
+        constexpr TraceSink() noexcept = default;
+
+        template <class Tracer, typename = lib::Require<!std::is_same_v<std::remove_const_t<Tracer>, TraceSink>>>
+        TraceSink(Tracer& tracer) noexcept
+        : self(&tracer)
+        , sink([](void* self, const TraceEvent& event) { (*static_cast<Tracer*>(self))(event); })
+        {}
+
+        constexpr explicit operator bool() const noexcept
+        {
+            return sink != nullptr;
+        }
+
+        constexpr void operator()(const TraceEvent& event) const
+        {
+            if (sink != nullptr) {
+                sink(self, event);
+            }
+        }
+    };
+}
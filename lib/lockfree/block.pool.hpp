@@ -0,0 +1,287 @@
+#pragma once
+#include <lib/typename.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+
+namespace lib::lockfree {
+
+    /// Пул блоков памяти по классам размеров: степени двойки от 64 байт до 1 МиБ,
+    /// блоки больше - напрямую из ::operator new. Освобождённые блоки сначала
+    /// попадают в кэш потока, излишки кэша - цепочкой в общий список класса.
+    /// Общий список только пополняется через CAS и забирается целиком через
+    /// exchange, поэтому проблемы ABA нет.
+    class BlockPool
+    {
+        constexpr static inline std::size_t min_shift   = 6;
+        constexpr static inline std::size_t max_shift   = 20;
+        constexpr static inline std::size_t classes     = max_shift - min_shift + 1;
+        constexpr static inline std::size_t cache_limit = 32;
+
+        struct Node
+        {
+            Node* next;
+        };
+
+        struct alignas(std::hardware_destructive_interference_size) FreeList
+        {
+            std::atomic<Node*> head {nullptr};
+        };
+
+        struct Cache
+        {
+            Node*       head  = nullptr;
+            std::size_t count = 0;
+        };
+
+        class ThreadCache
+        {
+            BlockPool& pool;
+        public:
+            std::array<Cache, classes> caches;
+
+            explicit ThreadCache(BlockPool& pool) noexcept
+            : pool(pool)
+            {}
+            ThreadCache(const ThreadCache&) = delete;
+            ThreadCache& operator=(const ThreadCache&) = delete;
+            ~ThreadCache() noexcept
+            {
+                for (std::size_t index = 0; index < classes; ++index) {
+                    pool.flush(index, caches[index]);
+                }
+            }
+        };
+
+        std::array<FreeList, classes> lists;
+
+        BlockPool() noexcept = default;
+    public:
+        BlockPool(const BlockPool&) = delete;
+        BlockPool& operator=(const BlockPool&) = delete;
+        ~BlockPool() noexcept
+        {
+            release();
+        }
+
+        static BlockPool& global() noexcept
+        {
+            static BlockPool pool;
+            return pool;
+        }
+
+        /// Размер блока, который на самом деле будет выделен под size байт.
+        constexpr static std::size_t capacity(std::size_t size) noexcept
+        {
+            if (size > (std::size_t(1) << max_shift)) {
+                return size;
+            }
+            return std::size_t(1) << (std::max)(min_shift, std::size_t(std::bit_width(size == 0 ? 0 : size - 1)));
+        }
+
+        void* allocate(std::size_t size)
+        {
+            if (size > (std::size_t(1) << max_shift)) {
+                return ::operator new(size);
+            }
+            const auto index = class_index(size);
+            auto& cache = local().caches[index];
+            if (cache.head == nullptr) {
+                adopt(index, cache);
+            }
+            if (Node* node = cache.head) {
+                cache.head = node->next;
+                cache.count -= 1;
+                return node;
+            }
+            return ::operator new(std::size_t(1) << (index + min_shift));
+        }
+
+        void deallocate(void* block, std::size_t size) noexcept
+        {
+            if (size > (std::size_t(1) << max_shift)) {
+                ::operator delete(block);
+                return;
+            }
+            const auto index = class_index(size);
+            auto& cache = local().caches[index];
+            cache.head = new (block) Node{cache.head};
+            cache.count += 1;
+            if (cache.count > cache_limit) {
+                // половину кэша - в общий список
+                Node* last = cache.head;
+                for (std::size_t i = 1; i < cache_limit / 2; ++i) {
+                    last = last->next;
+                }
+                Node* first = cache.head;
+                cache.head = last->next;
+                cache.count -= cache_limit / 2;
+                push(index, first, last);
+            }
+        }
+
+        /// Возвращает системе блоки из общих списков (кэши потоков не трогает).
+        void release() noexcept
+        {
+            for (std::size_t index = 0; index < classes; ++index) {
+                Node* node = lists[index].head.exchange(nullptr, std::memory_order_acquire);
+                while (node != nullptr) {
+                    ::operator delete(std::exchange(node, node->next));
+                }
+            }
+        }
+
+    private:
+        constexpr static std::size_t class_index(std::size_t size) noexcept
+        {
+            return std::bit_width(capacity(size)) - 1 - min_shift;
+        }
+
+        static ThreadCache& local() noexcept
+        {
+            thread_local ThreadCache cache(global());
+            return cache;
+        }
+
+        void push(std::size_t index, Node* first, Node* last) noexcept
+        {
+            auto& head = lists[index].head;
+            last->next = head.load(std::memory_order_relaxed);
+            while (!head.compare_exchange_weak(last->next, first, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+
+        /// Забирает общий список в кэш, лишнее сверх cache_limit возвращает обратно.
+        void adopt(std::size_t index, Cache& cache) noexcept
+        {
+            Node* node = lists[index].head.exchange(nullptr, std::memory_order_acquire);
+            if (node == nullptr) {
+                return;
+            }
+            cache.head = node;
+            cache.count = 1;
+            while (node->next != nullptr && cache.count < cache_limit) {
+                node = node->next;
+                cache.count += 1;
+            }
+            if (Node* rest = node->next) {
+                node->next = nullptr;
+                Node* last = rest;
+                while (last->next != nullptr) {
+                    last = last->next;
+                }
+                push(index, rest, last);
+            }
+        }
+
+        void flush(std::size_t index, Cache& cache) noexcept
+        {
+            if (cache.head == nullptr) {
+                return;
+            }
+            Node* last = cache.head;
+            while (last->next != nullptr) {
+                last = last->next;
+            }
+            push(index, cache.head, last);
+            cache = Cache{};
+        }
+    };
+
+    /// memory_resource поверх BlockPool::global(): потокобезопасный пул
+    /// для std::pmr-контейнеров и типов библиотеки, принимающих memory_resource.
+    class PoolResource: public std::pmr::memory_resource
+    {
+        PoolResource() noexcept = default;
+    public:
+        static PoolResource& global() noexcept
+        {
+            static PoolResource resource;
+            return resource;
+        }
+    private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override
+        {
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                return ::operator new(size, std::align_val_t(alignment));
+            }
+            return BlockPool::global().allocate(size);
+        }
+        void do_deallocate(void* block, std::size_t size, std::size_t alignment) override
+        {
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                ::operator delete(block, size, std::align_val_t(alignment));
+                return;
+            }
+            BlockPool::global().deallocate(block, size);
+        }
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    unittest {
+        static_assert(BlockPool::capacity(1) == 64);
+        static_assert(BlockPool::capacity(64) == 64);
+        static_assert(BlockPool::capacity(65) == 128);
+        static_assert(BlockPool::capacity(4096) == 4096);
+        static_assert(BlockPool::capacity(std::size_t(3) << 20) == std::size_t(3) << 20);
+
+        auto& pool = BlockPool::global();
+        void* a = pool.allocate(100);
+        pool.deallocate(a, 100);
+        void* b = pool.allocate(128);
+        check(a == b);
+        pool.deallocate(b, 128);
+
+        std::array<void*, 100> blocks {};
+        for (auto& block: blocks) {
+            block = pool.allocate(1000);
+        }
+        for (auto* block: blocks) {
+            pool.deallocate(block, 1000);
+        }
+        for (auto& block: blocks) {
+            block = pool.allocate(1000);
+        }
+        for (auto* block: blocks) {
+            pool.deallocate(block, 1000);
+        }
+    }
+
+    unittest {
+        auto& resource = PoolResource::global();
+        void* a = resource.allocate(200);
+        resource.deallocate(a, 200);
+        void* b = resource.allocate(256);
+        check(a == b);
+        resource.deallocate(b, 256);
+
+        void* aligned = resource.allocate(100, 256);
+        check(reinterpret_cast<std::uintptr_t>(aligned) % 256 == 0);
+        resource.deallocate(aligned, 100, 256);
+    }
+}
+
+namespace lib {
+    template <>
+    struct TypeName<lockfree::BlockPool>
+    {
+        constexpr static inline StaticString name = "lib::lockfree::BlockPool";
+    };
+
+    template <>
+    struct TypeName<lockfree::PoolResource>
+    {
+        constexpr static inline StaticString name = "lib::lockfree::PoolResource";
+    };
+}
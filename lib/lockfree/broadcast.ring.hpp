@@ -0,0 +1,304 @@
+#pragma once
+#include <lib/raw.storage.hpp>
+#include <lib/typename.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+
+namespace lib::lockfree {
+
+    /// Что делает писатель, если самый медленный читатель отстал на весь буфер.
+    enum class BroadcastGating: std::uint8_t
+    {
+        Block,      // писатель ждёт читателя
+        DropOldest, // читатель теряет самое старое сообщение
+        Detach,     // читатель отключается от кольца
+    };
+
+    /// Кольцевой буфер "один писатель - много читателей": каждое сообщение хранится
+    /// в единственном экземпляре, у каждого читателя свой курсор (номер сообщения).
+    /// Писатель может переписать ячейку, только когда все курсоры ушли дальше неё.
+    template <class T, std::size_t N, BroadcastGating Gating = BroadcastGating::Block, std::size_t MaxReaders = 32>
+    class BroadcastRing
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "size of the ring must be a power of two");
+
+        using Sequence = std::uint64_t;
+
+        constexpr static inline Sequence pinned_flag   = Sequence(1) << 62U;
+        constexpr static inline Sequence detached_position = ~Sequence(0) - 1;
+        constexpr static inline Sequence vacant_position   = ~Sequence(0);
+
+        struct alignas(std::hardware_destructive_interference_size) Cursor
+        {
+            std::atomic<Sequence> position {vacant_position};
+        };
+
+        alignas(std::hardware_destructive_interference_size) std::atomic<Sequence> head {0};
+        alignas(std::hardware_destructive_interference_size) Sequence gate = 0;
+
+        std::array<Cursor, MaxReaders> cursors;
+        std::array<RawStorage<T>, N> slots;
+
+    public:
+        class Reader;
+
+    public:
+        BroadcastRing() noexcept = default;
+        BroadcastRing(const BroadcastRing&) = delete;
+        BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+        ~BroadcastRing() noexcept
+        {
+            const auto last = head.load(std::memory_order_relaxed);
+            for (auto position = last > N ? last - N : 0; position < last; ++position) {
+                slots[position & (N - 1)].destroy();
+            }
+        }
+
+    public: // writer
+        /// Освобождает ячейку под следующее сообщение. Для DropOldest и Detach
+        /// отставших читателей сдвигает или отключает; false - если кольцо занято
+        /// (Block) или отставший читатель как раз держит самое старое сообщение.
+        bool reserve() noexcept
+        {
+            const auto position = head.load(std::memory_order_relaxed);
+            if (position - gate < N) {
+                return true;
+            }
+            gate = min_position(position);
+            if constexpr (Gating != BroadcastGating::Block) {
+                if (position - gate >= N) {
+                    const auto oldest = position - N;
+                    const auto evicted = Gating == BroadcastGating::DropOldest ? oldest + 1 : detached_position;
+                    for (auto& cursor: cursors) {
+                        auto expected = oldest;
+                        cursor.position.compare_exchange_strong(expected, evicted, std::memory_order_acq_rel);
+                    }
+                    gate = min_position(position);
+                }
+            }
+            return position - gate < N;
+        }
+
+        /// Можно вызывать только после успешного reserve().
+        template <class ...TArgs>
+        void publish(TArgs&& ...args) noexcept(std::is_nothrow_constructible_v<T, TArgs...>)
+        {
+            const auto position = head.load(std::memory_order_relaxed);
+            auto& slot = slots[position & (N - 1)];
+            if (position >= N) {
+                slot.destroy();
+            }
+            slot.emplace(std::forward<TArgs>(args)...);
+            head.store(position + 1, std::memory_order_release);
+        }
+
+        template <class U>
+        bool try_publish(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>)
+        {
+            if (reserve()) {
+                publish(std::forward<U>(value));
+                return true;
+            }
+            return false;
+        }
+
+        [[nodiscard]] bool active(std::size_t index) const noexcept
+        {
+            return cursors[index].position.load(std::memory_order_relaxed) < detached_position;
+        }
+
+        constexpr static std::size_t capacity() noexcept
+        {
+            return N;
+        }
+
+        constexpr static std::size_t max_readers() noexcept
+        {
+            return MaxReaders;
+        }
+
+    private:
+        Sequence min_position(Sequence position) const noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (const auto& cursor: cursors) {
+                const auto current = cursor.position.load(std::memory_order_acquire);
+                if (current < detached_position) {
+                    position = std::min(position, current & ~pinned_flag);
+                }
+            }
+            return position;
+        }
+    };
+
+    /// Курсор читателя. Читатель подключается с текущей позиции писателя и видит
+    /// только сообщения, опубликованные после подключения.
+    template <class T, std::size_t N, BroadcastGating Gating, std::size_t MaxReaders>
+    class BroadcastRing<T, N, Gating, MaxReaders>::Reader
+    {
+        BroadcastRing* ring   = nullptr;
+        Cursor*        cursor = nullptr;
+
+        mutable Sequence position = 0;
+        mutable Sequence lost_    = 0;
+
+    public:
+        explicit Reader(BroadcastRing& ring) noexcept
+        : ring(&ring)
+        {
+            for (auto& candidate: ring.cursors) {
+                auto expected = vacant_position;
+                auto start = ring.head.load(std::memory_order_seq_cst);
+                if (candidate.position.compare_exchange_strong(expected, start, std::memory_order_seq_cst)) {
+                    // писатель мог не увидеть курсор при последнем пересчёте gate,
+                    // поэтому начинаем не раньше, чем с позиции после записи курсора
+                    position = ring.head.load(std::memory_order_seq_cst);
+                    candidate.position.store(position, std::memory_order_seq_cst);
+                    cursor = &candidate;
+                    return;
+                }
+            }
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        ~Reader() noexcept
+        {
+            if (cursor != nullptr) {
+                cursor->position.store(vacant_position, std::memory_order_release);
+            }
+        }
+
+    public:
+        /// Число доступных сообщений. Для DropOldest и Detach текущее сообщение
+        /// закрепляется за читателем, и писатель не может его переписать до next().
+        std::size_t poll() const noexcept
+        {
+            if (cursor == nullptr) {
+                return 0;
+            }
+            auto current = cursor->position.load(std::memory_order_acquire);
+            while (true) {
+                if (current >= detached_position) {
+                    return 0;
+                }
+                if ((current & pinned_flag) != 0U) {
+                    return ring->head.load(std::memory_order_acquire) - position;
+                }
+                if (current != position) {
+                    lost_ += current - position;
+                    position = current;
+                }
+                const std::size_t count = ring->head.load(std::memory_order_acquire) - position;
+                if (Gating == BroadcastGating::Block || count == 0) {
+                    return count;
+                }
+                if (cursor->position.compare_exchange_weak(current, current | pinned_flag, std::memory_order_acq_rel)) {
+                    return count;
+                }
+            }
+        }
+
+        /// Можно вызывать только после poll() != 0.
+        const T& peek() const noexcept
+        {
+            return *ring->slots[position & (N - 1)].ptr();
+        }
+
+        void next() noexcept
+        {
+            position += 1;
+            cursor->position.store(position, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool detached() const noexcept
+        {
+            return cursor == nullptr || cursor->position.load(std::memory_order_acquire) == detached_position;
+        }
+
+        /// Сколько сообщений было пропущено из-за DropOldest.
+        [[nodiscard]] std::size_t lost() const noexcept
+        {
+            return lost_;
+        }
+
+        /// Номер курсора; max_readers(), если свободного курсора не нашлось.
+        [[nodiscard]] std::size_t index() const noexcept
+        {
+            if (cursor == nullptr) {
+                return MaxReaders;
+            }
+            return static_cast<std::size_t>(cursor - ring->cursors.data());
+        }
+    };
+
+    unittest {
+        BroadcastRing<int, 4> ring;
+        BroadcastRing<int, 4>::Reader fast(ring);
+        BroadcastRing<int, 4>::Reader slow(ring);
+
+        for (int i = 0; i < 4; ++i) {
+            check(ring.try_publish(i));
+        }
+        check(!ring.try_publish(4));
+        check(fast.poll() == 4 && slow.poll() == 4);
+        for (int i = 0; i < 4; ++i) {
+            check(fast.poll() != 0 && fast.peek() == i);
+            fast.next();
+        }
+        check(!ring.try_publish(4));
+        check(slow.peek() == 0);
+        slow.next();
+        check(ring.try_publish(4));
+        check(fast.poll() == 1 && fast.peek() == 4);
+        check(slow.poll() == 4 && slow.peek() == 1);
+    }
+
+    unittest {
+        BroadcastRing<int, 2, BroadcastGating::DropOldest> ring;
+        BroadcastRing<int, 2, BroadcastGating::DropOldest>::Reader reader(ring);
+
+        check(ring.try_publish(0));
+        check(ring.try_publish(1));
+        check(ring.try_publish(2));
+        check(ring.try_publish(3));
+        check(reader.poll() == 2 && reader.peek() == 2 && reader.lost() == 2);
+
+        // закреплённое сообщение не переписывается
+        check(!ring.try_publish(4));
+        reader.next();
+        check(ring.try_publish(4));
+        check(reader.poll() == 2 && reader.peek() == 3);
+    }
+
+    unittest {
+        BroadcastRing<int, 2, BroadcastGating::Detach> ring;
+        BroadcastRing<int, 2, BroadcastGating::Detach>::Reader reader(ring);
+        BroadcastRing<int, 2, BroadcastGating::Detach>::Reader lagging(ring);
+
+        check(ring.try_publish(0));
+        check(ring.try_publish(1));
+        check(reader.poll() == 2);
+        reader.next();
+        reader.next();
+        check(ring.try_publish(2));
+        check(lagging.detached() && lagging.poll() == 0);
+        check(!reader.detached() && reader.poll() == 1 && reader.peek() == 2);
+        check(!ring.active(lagging.index()) && ring.active(reader.index()));
+    }
+}
+
+namespace lib {
+    template <class T, std::size_t N, lockfree::BroadcastGating Gating, std::size_t MaxReaders>
+    struct TypeName<lockfree::BroadcastRing<T, N, Gating, MaxReaders>>
+    {
+        constexpr static inline StaticString name = "lib::lockfree::BroadcastRing<" + type_name<T> + ">";
+    };
+}
@@ -0,0 +1,531 @@
+#pragma once
+#include <lib/mutex.hpp>
+#include <lib/typename.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace lib::lockfree {
+
+    /// Хэш-таблица для общего кэша между потоками. Ключи распределены по Shards
+    /// частям, у каждой - мьютекс писателей и счётчик версий (seqlock): читатель
+    /// не берёт блокировок, а повторяет поиск, если во время чтения шла запись.
+    /// Ячейки хранятся как массивы атомарных слов, поэтому Key и Value должны быть
+    /// тривиально копируемыми. Таблицу, по которой идёт поиск, читатель публикует
+    /// в своей ячейке Readers (hazard pointer, каждая на своей кэш-линии); таблицы,
+    /// заменённые при росте или чистке удалённых ячеек, писатель освобождает, как
+    /// только их нет ни в одной ячейке. Неосвобождённых таблиц не больше Readers.
+    template <class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>, std::size_t Shards = 64, std::size_t Readers = 128>
+    class ConcurrentMap
+    {
+        static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+            "ConcurrentMap stores keys and values as atomic words");
+        static_assert(Shards != 0 && (Shards & (Shards - 1)) == 0, "number of shards must be a power of two");
+
+        struct alignas(std::uint64_t) Payload
+        {
+            Key   key;
+            Value value;
+        };
+
+        constexpr static inline std::size_t words = sizeof(Payload) / sizeof(std::uint64_t);
+        constexpr static inline std::size_t min_capacity = 16;
+
+        /// Тег ячейки: 0 - пусто, 1 - удалено, иначе хэш ключа.
+        enum: std::size_t
+        {
+            Empty   = 0,
+            Deleted = 1,
+        };
+
+        struct Slot
+        {
+            std::array<std::atomic<std::uint64_t>, words> data;
+
+            void store(const Payload& payload) noexcept
+            {
+                std::array<std::uint64_t, words> raw;
+                std::memcpy(raw.data(), &payload, sizeof(Payload));
+                for (std::size_t i = 0; i < words; ++i) {
+                    data[i].store(raw[i], std::memory_order_relaxed);
+                }
+            }
+            [[nodiscard]] Payload load() const noexcept
+            {
+                std::array<std::uint64_t, words> raw;
+                for (std::size_t i = 0; i < words; ++i) {
+                    raw[i] = data[i].load(std::memory_order_relaxed);
+                }
+                return std::bit_cast<Payload>(raw);
+            }
+        };
+
+        struct Table
+        {
+            std::size_t capacity;
+            std::size_t used = 0; // занятые и удалённые ячейки
+            std::unique_ptr<std::atomic<std::size_t>[]> tags;
+            std::unique_ptr<Slot[]> slots;
+
+            explicit Table(std::size_t capacity)
+            : capacity(capacity)
+            , tags(new std::atomic<std::size_t>[capacity])
+            , slots(new Slot[capacity])
+            {
+                for (std::size_t i = 0; i < capacity; ++i) {
+                    tags[i].store(Empty, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        struct alignas(std::hardware_destructive_interference_size) Shard
+        {
+            std::atomic<std::uint64_t> version {0};
+            std::atomic<Table*>        table {nullptr};
+            std::atomic<std::size_t>   size {0};
+            mutable Mutex              mutex;
+            std::vector<std::unique_ptr<Table>> tables; // последняя - текущая
+        };
+
+        /// Ячейка читателя: busy - занята потоком, table - таблица, которую нельзя освобождать.
+        struct alignas(std::hardware_destructive_interference_size) Hazard
+        {
+            std::atomic<bool>         busy {false};
+            std::atomic<const Table*> table {nullptr};
+        };
+
+        /// Ячейка на время одного get(); поток запоминает свою и обычно получает её же.
+        class ReadGuard
+        {
+            Hazard& hazard;
+        public:
+            explicit ReadGuard(Hazard& hazard) noexcept
+            : hazard(hazard)
+            {}
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+            ~ReadGuard() noexcept
+            {
+                hazard.table.store(nullptr, std::memory_order_release);
+                hazard.busy.store(false, std::memory_order_release);
+            }
+            /// Публикует текущую таблицу части; nullptr, если части ещё нет.
+            const Table* protect(const Shard& shard) noexcept
+            {
+                auto* table = shard.table.load(std::memory_order_seq_cst);
+                // пара с reclaim(): либо писатель увидит ячейку, либо читатель - новую таблицу
+                while (table != hazard.table.load(std::memory_order_relaxed)) {
+                    hazard.table.store(table, std::memory_order_seq_cst);
+                    table = shard.table.load(std::memory_order_seq_cst);
+                }
+                return table;
+            }
+        };
+
+        /// Запись в часть: нечётная версия означает, что таблица меняется.
+        class Writer
+        {
+            Shard& shard;
+            std::lock_guard<Mutex> lock;
+            std::uint64_t version;
+        public:
+            explicit Writer(Shard& shard)
+            : shard(shard)
+            , lock(shard.mutex)
+            , version(shard.version.load(std::memory_order_relaxed))
+            {
+                shard.version.store(version + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+            Writer(const Writer&) = delete;
+            Writer& operator=(const Writer&) = delete;
+            ~Writer() noexcept
+            {
+                shard.version.store(version + 2, std::memory_order_release);
+            }
+        };
+
+        std::array<Shard, Shards> shards;
+        mutable std::array<Hazard, Readers> hazards;
+        [[no_unique_address]] Hash     hash_;
+        [[no_unique_address]] KeyEqual equal_;
+    public:
+        ConcurrentMap() = default;
+        ConcurrentMap(const ConcurrentMap&) = delete;
+        ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+    public:
+        /// Поиск без блокировок.
+        [[nodiscard]] std::optional<Value> get(const Key& key) const noexcept
+        {
+            const auto hash = tag(key);
+            const auto& shard = shard_for(hash);
+            ReadGuard guard(acquire_hazard());
+            while (true) {
+                const auto version = shard.version.load(std::memory_order_acquire);
+                if ((version & 1U) != 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const auto* table = guard.protect(shard);
+                auto result = table != nullptr ? lookup(*table, key, hash) : std::nullopt;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (shard.version.load(std::memory_order_relaxed) == version) {
+                    return result;
+                }
+            }
+        }
+        [[nodiscard]] bool contains(const Key& key) const noexcept
+        {
+            return get(key).has_value();
+        }
+
+        /// false, если ключ уже есть (значение не меняется).
+        bool insert(const Key& key, const Value& value)
+        {
+            const auto hash = tag(key);
+            auto& shard = shard_for(hash);
+            Writer writer(shard);
+            return put(shard, Payload{key, value}, hash, false);
+        }
+        /// true, если ключ добавлен, false - если значение заменено.
+        bool insert_or_assign(const Key& key, const Value& value)
+        {
+            const auto hash = tag(key);
+            auto& shard = shard_for(hash);
+            Writer writer(shard);
+            return put(shard, Payload{key, value}, hash, true);
+        }
+        /// Вставка диапазона пар: элементы группируются по частям, каждая часть
+        /// блокируется один раз. Возвращает число добавленных ключей.
+        template <std::input_iterator Iterator>
+        std::size_t insert_or_assign(Iterator first, Iterator last)
+        {
+            std::array<std::vector<std::pair<Payload, std::size_t>>, Shards> groups;
+            for (; first != last; ++first) {
+                const auto& [key, value] = *first;
+                const auto hash = tag(key);
+                groups[hash & (Shards - 1)].emplace_back(Payload{key, value}, hash);
+            }
+            std::size_t inserted = 0;
+            for (std::size_t index = 0; index < Shards; ++index) {
+                if (groups[index].empty()) {
+                    continue;
+                }
+                auto& shard = shards[index];
+                Writer writer(shard);
+                reserve(shard, groups[index].size());
+                for (const auto& [payload, hash]: groups[index]) {
+                    inserted += put(shard, payload, hash, true) ? 1 : 0;
+                }
+            }
+            return inserted;
+        }
+        bool erase(const Key& key)
+        {
+            const auto hash = tag(key);
+            auto& shard = shard_for(hash);
+            Writer writer(shard);
+            reclaim(shard);
+            auto* table = shard.table.load(std::memory_order_relaxed);
+            if (table == nullptr) {
+                return false;
+            }
+            const auto index = find(*table, key, hash);
+            if (index == table->capacity) {
+                return false;
+            }
+            table->tags[index].store(Deleted, std::memory_order_relaxed);
+            shard.size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /// Число элементов; при параллельной записи - приблизительное.
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            std::size_t result = 0;
+            for (const auto& shard: shards) {
+                result += shard.size.load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        /// Копия содержимого: каждая часть копируется целиком в согласованном
+        /// состоянии, но разные части - в разные моменты времени.
+        [[nodiscard]] std::vector<std::pair<Key, Value>> snapshot() const
+        {
+            std::vector<std::pair<Key, Value>> result;
+            result.reserve(size());
+            for (const auto& shard: shards) {
+                std::lock_guard lock(shard.mutex);
+                const auto* table = shard.table.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; table != nullptr && i < table->capacity; ++i) {
+                    if (table->tags[i].load(std::memory_order_relaxed) > Deleted) {
+                        const auto payload = table->slots[i].load();
+                        result.emplace_back(payload.key, payload.value);
+                    }
+                }
+            }
+            return result;
+        }
+
+        /// Освобождает все таблицы; нельзя вызывать одновременно с читателями.
+        void clear() noexcept
+        {
+            for (auto& shard: shards) {
+                std::lock_guard lock(shard.mutex);
+                shard.table.store(nullptr, std::memory_order_relaxed);
+                shard.tables.clear();
+                shard.size.store(0, std::memory_order_relaxed);
+            }
+        }
+    private:
+        [[nodiscard]] std::size_t tag(const Key& key) const noexcept
+        {
+            const auto value = static_cast<std::uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ULL;
+            const auto hash = static_cast<std::size_t>(value ^ (value >> 32U));
+            return hash > Deleted ? hash : hash + 2;
+        }
+        /// Свободная ячейка читателя, начиная с той, что поток занимал в прошлый раз.
+        Hazard& acquire_hazard() const noexcept
+        {
+            thread_local std::size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+            for (std::size_t attempt = 0;; ++attempt) {
+                auto& hazard = hazards[(hint + attempt) % Readers];
+                if (!hazard.busy.load(std::memory_order_relaxed) && !hazard.busy.exchange(true, std::memory_order_acquire)) {
+                    hint += attempt;
+                    return hazard;
+                }
+                if (attempt != 0 && attempt % Readers == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        [[nodiscard]] const Shard& shard_for(std::size_t hash) const noexcept
+        {
+            return shards[hash & (Shards - 1)];
+        }
+        [[nodiscard]] Shard& shard_for(std::size_t hash) noexcept
+        {
+            return shards[hash & (Shards - 1)];
+        }
+        constexpr static std::size_t start(const Table& table, std::size_t hash) noexcept
+        {
+            // младшие биты уже выбрали часть
+            return (hash >> std::countr_zero(Shards)) & (table.capacity - 1);
+        }
+
+        /// Чтение под seqlock: таблица может меняться, поэтому число шагов ограничено ёмкостью.
+        std::optional<Value> lookup(const Table& table, const Key& key, std::size_t hash) const noexcept
+        {
+            auto index = start(table, hash);
+            for (std::size_t step = 0; step < table.capacity; ++step) {
+                const auto current = table.tags[index].load(std::memory_order_relaxed);
+                if (current == Empty) {
+                    break;
+                }
+                if (current == hash) {
+                    const auto payload = table.slots[index].load();
+                    if (equal_(payload.key, key)) {
+                        return payload.value;
+                    }
+                }
+                index = (index + 1) & (table.capacity - 1);
+            }
+            return std::nullopt;
+        }
+
+        /// Индекс ключа или capacity; только под мьютексом части.
+        std::size_t find(const Table& table, const Key& key, std::size_t hash) const noexcept
+        {
+            auto index = start(table, hash);
+            while (true) {
+                const auto current = table.tags[index].load(std::memory_order_relaxed);
+                if (current == Empty) {
+                    return table.capacity;
+                }
+                if (current == hash && equal_(table.slots[index].load().key, key)) {
+                    return index;
+                }
+                index = (index + 1) & (table.capacity - 1);
+            }
+        }
+
+        bool put(Shard& shard, const Payload& payload, std::size_t hash, bool assign)
+        {
+            reserve(shard, 1);
+            auto& table = *shard.table.load(std::memory_order_relaxed);
+            auto index = start(table, hash);
+            auto free = table.capacity;
+            while (true) {
+                const auto current = table.tags[index].load(std::memory_order_relaxed);
+                if (current == Empty) {
+                    break;
+                }
+                if (current == Deleted) {
+                    free = free == table.capacity ? index : free;
+                } else if (current == hash && equal_(table.slots[index].load().key, payload.key)) {
+                    if (assign) {
+                        table.slots[index].store(payload);
+                    }
+                    return false;
+                }
+                index = (index + 1) & (table.capacity - 1);
+            }
+            if (free == table.capacity) {
+                free = index;
+                table.used += 1;
+            }
+            table.slots[free].store(payload);
+            table.tags[free].store(hash, std::memory_order_relaxed);
+            shard.size.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /// Гарантирует место ещё под count ключей при заполнении не выше 3/4.
+        void reserve(Shard& shard, std::size_t count)
+        {
+            reclaim(shard);
+            auto* table = shard.table.load(std::memory_order_relaxed);
+            if (table != nullptr && (table->used + count) * 4 <= table->capacity * 3) {
+                return;
+            }
+            const auto size = shard.size.load(std::memory_order_relaxed);
+            auto capacity = table != nullptr ? table->capacity : min_capacity;
+            while ((size + count) * 4 > capacity * 3) {
+                capacity *= 2;
+            }
+            auto next = std::make_unique<Table>(capacity);
+            for (std::size_t i = 0; table != nullptr && i < table->capacity; ++i) {
+                const auto current = table->tags[i].load(std::memory_order_relaxed);
+                if (current > Deleted) {
+                    auto index = start(*next, current);
+                    while (next->tags[index].load(std::memory_order_relaxed) != Empty) {
+                        index = (index + 1) & (capacity - 1);
+                    }
+                    next->slots[index].store(table->slots[i].load());
+                    next->tags[index].store(current, std::memory_order_relaxed);
+                    next->used += 1;
+                }
+            }
+            shard.table.store(next.get(), std::memory_order_seq_cst);
+            shard.tables.push_back(std::move(next));
+            reclaim(shard);
+        }
+
+        /// Освобождает заменённые таблицы, которых нет в ячейках читателей:
+        /// пришедшие позже уже загрузят текущую. Только под мьютексом части.
+        void reclaim(Shard& shard) noexcept
+        {
+            if (shard.tables.size() < 2) {
+                return;
+            }
+            const auto retired = std::prev(shard.tables.end());
+            const auto end = std::remove_if(shard.tables.begin(), retired, [this](const auto& table) {
+                return std::none_of(hazards.begin(), hazards.end(), [&](const Hazard& hazard) {
+                    return hazard.table.load(std::memory_order_seq_cst) == table.get();
+                });
+            });
+            shard.tables.erase(end, retired);
+        }
+    };
+
+    unittest {
+        ConcurrentMap<int, long, std::hash<int>, std::equal_to<int>, 4> map;
+        check(!map.get(1));
+
+        for (int i = 0; i < 1000; ++i) {
+            check(map.insert(i, i * 10L));
+        }
+        check(!map.insert(5, 0));
+        check(!map.insert_or_assign(5, 7));
+        check(map.get(5) == 7L);
+        check(map.size() == 1000);
+
+        for (int i = 0; i < 1000; i += 2) {
+            check(map.erase(i));
+        }
+        check(!map.erase(0));
+        check(map.size() == 500 && !map.contains(10) && map.get(11) == 110L);
+
+        std::vector<std::pair<int, long>> bulk;
+        for (int i = 0; i < 2000; i += 2) {
+            bulk.emplace_back(i, -i);
+        }
+        check(map.insert_or_assign(bulk.begin(), bulk.end()) == 1000);
+        check(map.size() == 1500 && map.get(1998) == -1998L);
+
+        const auto items = map.snapshot();
+        check(items.size() == 1500);
+
+        map.clear();
+        check(map.empty() && !map.get(1));
+    }
+
+    unittest {
+        // удалённые ячейки заставляют пересобирать таблицу того же размера
+        ConcurrentMap<int, int, std::hash<int>, std::equal_to<int>, 1> map;
+        bool ok = true;
+        for (int i = 0; i < 100000; ++i) {
+            ok = ok && map.insert(i, i) && map.erase(i);
+        }
+        check(ok && map.empty() && !map.get(99999));
+    }
+
+    unittest {
+        ConcurrentMap<std::uint64_t, std::uint64_t> map;
+        std::atomic_bool torn = false;
+        std::vector<std::thread> readers;
+        std::atomic_bool stop = false;
+        for (int r = 0; r < 3; ++r) {
+            readers.emplace_back([&] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    for (std::uint64_t key = 0; key < 256; ++key) {
+                        if (auto value = map.get(key); value && *value != key * 3) {
+                            torn = true;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::uint64_t round = 0; round < 20; ++round) {
+            for (std::uint64_t key = 0; key < 4096; ++key) {
+                map.insert_or_assign(key, key * 3);
+            }
+            for (std::uint64_t key = 0; key < 4096; key += 3) {
+                map.erase(key);
+            }
+        }
+        stop = true;
+        for (auto& reader: readers) {
+            reader.join();
+        }
+        check(!torn);
+    }
+}
+
+namespace lib {
+    template <class Key, class Value, class Hash, class KeyEqual, std::size_t Shards, std::size_t Readers>
+    struct TypeName<lockfree::ConcurrentMap<Key, Value, Hash, KeyEqual, Shards, Readers>>
+    {
+        constexpr static inline StaticString name = "lib::lockfree::ConcurrentMap<" + type_name<Key> + ", " + type_name<Value> + ">";
+    };
+}
@@ -0,0 +1,425 @@
+#pragma once
+#include <lib/test.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace lib {
+
+	template <std::size_t States = 0, std::size_t Width = 0>
+	class regex_dfa;
+
+	/// Автомат Томпсона над байтами. Комбинаторы regex дописывают в него свои
+	/// фрагменты, determinize() строит по нему минимальный ДКА.
+	class regex_nfa
+	{
+	public:
+		using state_t = std::uint32_t;
+
+		struct fragment
+		{
+			state_t begin;
+			state_t end;
+		};
+	private:
+		struct edge
+		{
+			state_t from;
+			state_t to;
+			std::uint8_t lo;
+			std::uint8_t hi;
+			bool epsilon;
+		};
+
+		std::vector<edge> edges;
+		state_t count = 0;
+	public:
+		constexpr state_t state()
+		{
+			return count++;
+		}
+		constexpr void epsilon(state_t from, state_t to)
+		{
+			edges.push_back(edge{from, to, 0, 0, true});
+		}
+		template <class T>
+		constexpr void range(state_t from, state_t to, T lo, T hi)
+		{
+			static_assert(sizeof(T) == 1, "regex_nfa is built over a byte alphabet");
+			const auto ulo = static_cast<std::uint8_t>(lo);
+			const auto uhi = static_cast<std::uint8_t>(hi);
+			// пустой диапазон определяется сравнением T, как в regex<match_range_t>
+			if(hi < lo)
+				return;
+			if(ulo <= uhi) {
+				edges.push_back(edge{from, to, ulo, uhi, false});
+			} else {
+				// знаковый диапазон через ноль: [-5, 5] это [251, 255] и [0, 5]
+				edges.push_back(edge{from, to, ulo, 0xFF, false});
+				edges.push_back(edge{from, to, 0, uhi, false});
+			}
+		}
+		template <class T>
+		constexpr void symbol(state_t from, state_t to, T value)
+		{
+			range(from, to, value, value);
+		}
+	public:
+		constexpr fragment concat(fragment a, fragment b)
+		{
+			epsilon(a.end, b.begin);
+			return fragment{a.begin, b.end};
+		}
+		constexpr fragment optional(fragment a)
+		{
+			epsilon(a.begin, a.end);
+			return a;
+		}
+		constexpr fragment plus(fragment a)
+		{
+			const auto begin = state();
+			const auto end = state();
+			epsilon(begin, a.begin);
+			epsilon(a.end, a.begin);
+			epsilon(a.end, end);
+			return fragment{begin, end};
+		}
+		constexpr fragment star(fragment a)
+		{
+			return optional(plus(a));
+		}
+	public:
+		/// Построение подмножеств по классам эквивалентности байтов и минимизация Мура.
+		constexpr regex_dfa<> determinize(fragment root) const;
+	};
+
+	/// Таблица переходов: байт -> класс, (состояние, класс) -> состояние.
+	/// Состояние 0 - тупиковое, на нём сопоставление останавливается.
+	/// regex_dfa<> хранит таблицу в векторах, regex_dfa<States, Width> - в массивах
+	/// и может быть constexpr-переменной.
+	template <std::size_t States, std::size_t Width>
+	class regex_dfa
+	{
+		template <std::size_t, std::size_t>
+		friend class regex_dfa;
+		friend class regex_nfa;
+	public:
+		using state_t = std::uint16_t;
+		constexpr static inline state_t dead = 0;
+		constexpr static inline bool fixed = States != 0;
+	private:
+		template <class T, std::size_t Size>
+		using storage = std::conditional_t<fixed, std::array<T, Size>, std::vector<T>>;
+
+		std::array<std::uint8_t, 256> classes{};
+		storage<state_t, States * Width> transitions{};
+		storage<std::uint8_t, States> accept{};
+		std::size_t width = Width;
+		state_t start = dead;
+	public:
+		constexpr regex_dfa() noexcept = default;
+		template <std::size_t S, std::size_t W>
+			requires (fixed && S == 0 && W == 0)
+		constexpr explicit regex_dfa(const regex_dfa<S, W>& dfa)
+		: classes(dfa.classes)
+		, start(dfa.start)
+		{
+			if(dfa.states() != States || dfa.width != Width) {
+				throw std::length_error("regex_dfa: table shape mismatch");
+			}
+			std::copy(dfa.transitions.begin(), dfa.transitions.end(), transitions.begin());
+			std::copy(dfa.accept.begin(), dfa.accept.end(), accept.begin());
+		}
+	public:
+		[[nodiscard]] constexpr std::size_t states() const noexcept
+		{
+			return accept.size();
+		}
+		/// Число классов эквивалентности байтов - ширина строки таблицы.
+		[[nodiscard]] constexpr std::size_t classes_count() const noexcept
+		{
+			return width;
+		}
+		[[nodiscard]] constexpr bool empty() const noexcept
+		{
+			return start == dead;
+		}
+		[[nodiscard]] constexpr state_t initial() const noexcept
+		{
+			return start;
+		}
+		[[nodiscard]] constexpr state_t next(state_t state, unsigned char symbol) const noexcept
+		{
+			return transitions[state * width + classes[symbol]];
+		}
+		[[nodiscard]] constexpr bool accepting(state_t state) const noexcept
+		{
+			return accept[state] != 0;
+		}
+	public:
+		/// Самое длинное принимаемое начало [it, end): при успехе it сдвигается за него.
+		template <class Begin, class End>
+		constexpr bool operator()(Begin& it, End end) const
+		{
+			state_t state = start;
+			bool matched = accepting(state);
+			Begin last = it;
+			for(Begin cursor = it; state != dead && cursor != end;) {
+				state = next(state, static_cast<unsigned char>(*cursor));
+				++cursor;
+				if(accepting(state)) {
+					matched = true;
+					last = cursor;
+				}
+			}
+			if(matched) {
+				it = last;
+			}
+			return matched;
+		}
+		/// Принимается ли строка целиком.
+		template <class T, std::size_t Size>
+		constexpr bool operator()(const T(&value)[Size]) const
+		{
+			state_t state = start;
+			for(std::size_t i = 0; i + 1 < Size && state != dead; ++i) {
+				state = next(state, static_cast<unsigned char>(value[i]));
+			}
+			return accepting(state);
+		}
+	};
+
+	constexpr regex_dfa<> regex_nfa::determinize(fragment root) const
+	{
+		using dstate_t = regex_dfa<>::state_t;
+
+		// классы: байты, которые ни одна дуга не различает, получают один номер
+		std::array<bool, 257> split{};
+		for(const auto& e: edges) {
+			if(!e.epsilon) {
+				split[e.lo] = true;
+				split[e.hi + 1] = true;
+			}
+		}
+		regex_dfa<> dfa;
+		std::size_t width = 0;
+		for(std::size_t b = 0; b < 256; ++b) {
+			if(b != 0 && split[b]) {
+				++width;
+			}
+			dfa.classes[b] = static_cast<std::uint8_t>(width);
+		}
+		width += 1;
+
+		struct arc
+		{
+			state_t to;
+			std::size_t lo;
+			std::size_t hi;
+		};
+		std::vector<std::vector<state_t>> epsilons(count);
+		std::vector<std::vector<arc>> arcs(count);
+		for(const auto& e: edges) {
+			if(e.epsilon) {
+				epsilons[e.from].push_back(e.to);
+			} else {
+				arcs[e.from].push_back(arc{e.to, dfa.classes[e.lo], dfa.classes[e.hi]});
+			}
+		}
+
+		std::vector<std::uint32_t> marks(count, 0);
+		std::uint32_t stamp = 0;
+		auto closure = [&](std::vector<state_t>& set) {
+			for(std::size_t i = 0; i < set.size(); ++i) {
+				for(auto to: epsilons[set[i]]) {
+					if(marks[to] != stamp) {
+						marks[to] = stamp;
+						set.push_back(to);
+					}
+				}
+			}
+			std::sort(set.begin(), set.end());
+		};
+
+		// подмножества: 0 - пустое (тупик), 1 - замыкание начала
+		std::vector<std::vector<state_t>> sets(1);
+		std::vector<state_t> next;
+		std::vector<std::uint8_t> accept(1, 0);
+		{
+			std::vector<state_t> initial{root.begin};
+			marks[root.begin] = ++stamp;
+			closure(initial);
+			sets.push_back(std::move(initial));
+		}
+		for(std::size_t d = 0; d < sets.size(); ++d) {
+			if(d != 0) {
+				accept.push_back(std::binary_search(sets[d].begin(), sets[d].end(), root.end));
+			}
+			for(std::size_t c = 0; c < width; ++c) {
+				std::vector<state_t> target;
+				++stamp;
+				for(auto from: sets[d]) {
+					for(const auto& a: arcs[from]) {
+						if(a.lo <= c && c <= a.hi && marks[a.to] != stamp) {
+							marks[a.to] = stamp;
+							target.push_back(a.to);
+						}
+					}
+				}
+				closure(target);
+				const auto found = std::find(sets.begin(), sets.end(), target);
+				next.push_back(static_cast<state_t>(found - sets.begin()));
+				if(found == sets.end()) {
+					sets.push_back(std::move(target));
+				}
+			}
+		}
+		const std::size_t n = sets.size();
+
+		// Мур: дробим разбиение по номерам блоков преемников, пока оно меняется
+		std::vector<std::size_t> block(accept.begin(), accept.end());
+		std::vector<std::size_t> refined(n);
+		std::vector<std::size_t> order(n);
+		const auto less = [&](std::size_t s, std::size_t t) {
+			if(block[s] != block[t]) {
+				return block[s] < block[t];
+			}
+			for(std::size_t c = 0; c < width; ++c) {
+				const auto bs = block[next[s * width + c]];
+				const auto bt = block[next[t * width + c]];
+				if(bs != bt) {
+					return bs < bt;
+				}
+			}
+			return false;
+		};
+		for(std::size_t blocks = 0;;) {
+			std::iota(order.begin(), order.end(), std::size_t(0));
+			std::sort(order.begin(), order.end(), less);
+			std::size_t count = 0;
+			for(std::size_t i = 0; i < n; ++i) {
+				if(i != 0 && less(order[i - 1], order[i])) {
+					++count;
+				}
+				refined[order[i]] = count;
+			}
+			block.swap(refined);
+			if(count + 1 == blocks) {
+				break;
+			}
+			blocks = count + 1;
+		}
+
+		// нумерация по первому состоянию блока: блок тупика остаётся нулевым
+		std::vector<std::size_t> number(n, n);
+		std::vector<std::size_t> representative;
+		for(std::size_t s = 0; s < n; ++s) {
+			if(number[block[s]] == n) {
+				number[block[s]] = representative.size();
+				representative.push_back(s);
+			}
+		}
+		if(representative.size() > std::numeric_limits<dstate_t>::max()) {
+			throw std::length_error("regex_nfa: too many DFA states");
+		}
+
+		// столбцы, совпавшие после минимизации, сливаются в один класс
+		std::vector<std::size_t> column(width);
+		std::vector<std::size_t> columns;
+		for(std::size_t c = 0; c < width; ++c) {
+			column[c] = columns.size();
+			for(std::size_t k = 0; k < columns.size(); ++k) {
+				bool same = true;
+				for(auto s: representative) {
+					same = same && block[next[s * width + c]] == block[next[s * width + columns[k]]];
+				}
+				if(same) {
+					column[c] = k;
+					break;
+				}
+			}
+			if(column[c] == columns.size()) {
+				columns.push_back(c);
+			}
+		}
+		for(auto& c: dfa.classes) {
+			c = static_cast<std::uint8_t>(column[c]);
+		}
+
+		dfa.width = columns.size();
+		dfa.start = static_cast<dstate_t>(number[block[1]]);
+		for(auto s: representative) {
+			dfa.accept.push_back(accept[s]);
+			for(auto c: columns) {
+				dfa.transitions.push_back(static_cast<dstate_t>(number[block[next[s * width + c]]]));
+			}
+		}
+		return dfa;
+	}
+
+	unittest {
+		// [a-z_][a-z0-9_]*
+		constexpr auto identifier = [] {
+			regex_nfa nfa;
+			auto head = nfa.state();
+			auto body = nfa.state();
+			nfa.range(head, body, 'a', 'z');
+			nfa.symbol(head, body, '_');
+			auto loop = regex_nfa::fragment{nfa.state(), nfa.state()};
+			nfa.range(loop.begin, loop.end, 'a', 'z');
+			nfa.range(loop.begin, loop.end, '0', '9');
+			nfa.symbol(loop.begin, loop.end, '_');
+			return nfa.determinize(nfa.concat({head, body}, nfa.star(loop)));
+		};
+		// тупик, начало и принимающее состояние; классы: [a-z_], [0-9], остальное
+		static_assert(identifier().states() == 3);
+		static_assert(identifier().classes_count() == 3);
+
+		const auto dfa = identifier();
+		check(dfa("some_value_0"));
+		check(dfa("_"));
+		check(!dfa("0abc"));
+		check(!dfa(""));
+
+		const char text[] = "value+1";
+		const char* it = text;
+		check(dfa(it, text + 7) && it == text + 5);
+		it = text + 5;
+		check(!dfa(it, text + 7) && it == text + 5);
+
+		constexpr regex_dfa<3, 3> table(identifier());
+		static_assert(table("abc") && !table("1bc"));
+	}
+
+	unittest {
+		// (a|b)*abb: минимальный ДКА из учебника - 4 состояния и тупик
+		regex_nfa nfa;
+		auto ab = regex_nfa::fragment{nfa.state(), nfa.state()};
+		nfa.range(ab.begin, ab.end, 'a', 'b');
+		auto tail = regex_nfa::fragment{nfa.state(), nfa.state()};
+		auto middle = nfa.state();
+		auto last = nfa.state();
+		nfa.symbol(tail.begin, middle, 'a');
+		nfa.symbol(middle, last, 'b');
+		nfa.symbol(last, tail.end, 'b');
+		const auto dfa = nfa.determinize(nfa.concat(nfa.star(ab), tail));
+		check(dfa.states() == 5);
+		check(dfa("abb") && dfa("babb") && dfa("aababb"));
+		check(!dfa("ab") && !dfa("abba") && !dfa("abbc"));
+
+		// знаковый диапазон через ноль
+		regex_nfa wide;
+		auto range = regex_nfa::fragment{wide.state(), wide.state()};
+		wide.range(range.begin, range.end, char(-3), char(3));
+		const auto signed_dfa = wide.determinize(range);
+		const char inside[] = {char(-2), '\0'};
+		const char outside[] = {char(100), '\0'};
+		check(signed_dfa(inside) && signed_dfa("\1") && !signed_dfa(outside));
+	}
+}
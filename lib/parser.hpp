@@ -5,9 +5,14 @@
 #include <string>
 #include <optional>
 #include <variant>
+#include <tuple>
 #include <vector>
 #include <algorithm>
+#include <iterator>
+#include <type_traits>
 #include <lib/typetraits/tag.hpp>
+#include <lib/buffer.simd.hpp>
+#include <lib/parser.dfa.hpp>
 
 namespace lib {
 
@@ -112,6 +117,17 @@ namespace lib {
 		{
 			return std::equal(a.values.begin(), a.values.end(), b.values.begin(), b.values.end());
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			const auto begin = nfa.state();
+			auto end = begin;
+			for(const auto& value: values) {
+				const auto next = nfa.state();
+				nfa.symbol(end, next, value);
+				end = next;
+			}
+			return regex_nfa::fragment{begin, end};
+		}
 	};
 
 	template <std::size_t max>
@@ -143,11 +159,21 @@ namespace lib {
 	{
 		using index_t = regex_index_from_max_value_v<Size>;
 		std::array<T, Size> values;
+		buffer::simd::ByteSet bytes;
+		std::array<index_t, 256> indexes{};
 	public:
 		template <index_t... I>
 		constexpr regex(const T(&array)[Size + 1], std::integer_sequence<index_t, I...>) noexcept
 		: values{array[I]...}
-		{}
+		{
+			if constexpr(sizeof(T) == 1) {
+				indexes.fill(Size);
+				for(index_t i = Size; i-- > 0;) {
+					bytes.insert(static_cast<std::uint8_t>(values[i]));
+					indexes[static_cast<std::uint8_t>(values[i])] = i;
+				}
+			}
+		}
 		constexpr regex(const T(&array)[Size + 1]) noexcept
 		: regex(array, std::make_integer_sequence<index_t, Size>())
 		{}
@@ -174,19 +200,41 @@ namespace lib {
 		template <class Begin, class End>
 		constexpr result_t operator()(Begin& it, End end) const
 		{
-			const auto mbegin = values.begin();
-			const auto mend = values.end();
 			if(it != end)
 			{
-				for(index_t i = 0; i < Size; ++i) {
-					if(values[i] == *it) {
-						it += 1;
-						return result_t{i};
-					}
+				if(const auto i = value(*it); i < Size) {
+					it += 1;
+					return result_t{i};
 				}
 			}
 			return result_t{};
 		}
+		/// Индекс символа в наборе или Size.
+		constexpr value_type value(const T& symbol) const noexcept
+		{
+			if constexpr(sizeof(T) == 1) {
+				return indexes[static_cast<std::uint8_t>(symbol)];
+			} else {
+				for(index_t i = 0; i < Size; ++i) {
+					if(values[i] == symbol)
+						return i;
+				}
+				return Size;
+			}
+		}
+		/// Первый символ не из набора; непрерывные байтовые диапазоны
+		/// проверяются по 16-32 байта за шаг.
+		template <class Begin, class End>
+		constexpr Begin skip(Begin it, End end) const
+		{
+			if constexpr(sizeof(T) == 1 && std::contiguous_iterator<Begin> && std::sized_sentinel_for<End, Begin>) {
+				if(!std::is_constant_evaluated())
+					return it + buffer::simd::span(std::to_address(it), end - it, bytes);
+			}
+			while(it != end && value(*it) < Size)
+				++it;
+			return it;
+		}
 		template <std::size_t ISize>
 		constexpr result_t operator()(const T(&value)[ISize]) const
 		{
@@ -226,6 +274,13 @@ namespace lib {
 					return false;
 			return true;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			const regex_nfa::fragment result{nfa.state(), nfa.state()};
+			for(const auto& value: values)
+				nfa.symbol(result.begin, result.end, value);
+			return result;
+		}
 	};
 
 	template <class T>
@@ -235,10 +290,24 @@ namespace lib {
 	class regex<match_range_t<T>>
 	{
 		T from, to;
+		buffer::simd::ByteSet bytes;
 	public:
 		constexpr regex(T from, T to) noexcept
 		: from(from), to(to)
-		{}
+		{
+			// границы сравниваются как T, как и в operator(): при from > to диапазон пуст
+			if constexpr(sizeof(T) == 1) {
+				const auto lo = static_cast<std::uint8_t>(from);
+				const auto hi = static_cast<std::uint8_t>(to);
+				if(to < from)
+					return;
+				if(lo <= hi) {
+					bytes.insert(lo, hi);
+				} else {
+					bytes.insert(lo, 0xFF).insert(0, hi);
+				}
+			}
+		}
 		regex(regex&&) = default;
 		regex(const regex&) = default;
 		regex& operator=(const regex&) = default;
@@ -261,6 +330,22 @@ namespace lib {
 			}
 			return std::nullopt;
 		}
+		constexpr value_type value(const T& symbol) const noexcept
+		{
+			return symbol;
+		}
+		/// Первый символ вне диапазона; см. regex<match_anyof_t>::skip.
+		template <class Begin, class End>
+		constexpr Begin skip(Begin it, End end) const
+		{
+			if constexpr(sizeof(T) == 1 && std::contiguous_iterator<Begin> && std::sized_sentinel_for<End, Begin>) {
+				if(!std::is_constant_evaluated())
+					return it + buffer::simd::span(std::to_address(it), end - it, bytes);
+			}
+			while(it != end && *it >= from && *it <= to)
+				++it;
+			return it;
+		}
 		template <std::size_t Size>
 		constexpr auto operator()(const char(&value)[Size]) const
 		{
@@ -293,6 +378,12 @@ namespace lib {
 		{
 			return a.from == b.from && a.to == b.to;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			const regex_nfa::fragment result{nfa.state(), nfa.state()};
+			nfa.range(result.begin, result.end, from, to);
+			return result;
+		}
 	};
 
 	struct match_t
@@ -417,6 +508,18 @@ namespace lib {
 		{
 			return a.matches == b.matches;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			const regex_nfa::fragment result{nfa.state(), nfa.state()};
+			const auto alternative = [&](regex_nfa::fragment match) {
+				nfa.epsilon(result.begin, match.begin);
+				nfa.epsilon(match.end, result.end);
+			};
+			std::apply([&](const auto& ...match) {
+				(alternative(match.compile(nfa)), ...);
+			}, matches);
+			return result;
+		}
 	};
 
 	namespace details {
@@ -610,6 +713,14 @@ namespace lib {
 		{
 			return a.matches == b.matches;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			return std::apply([&](const auto& head, const auto& ...tail) {
+				auto result = head.compile(nfa);
+				((result = nfa.concat(result, tail.compile(nfa))), ...);
+				return result;
+			}, matches);
+		}
 	};
 
 	namespace details
@@ -726,8 +837,17 @@ namespace lib {
 		constexpr result_t operator()(Begin& it, End end) const
 		{
 			value_type results;
-			while(auto result = match(it, end)) {
-				results.emplace_back(*std::move(result));
+			if constexpr(requires { it = match.skip(it, end); }) {
+				// серия одиночных символов класса: границу находит векторный skip
+				const auto from = it;
+				it = match.skip(it, end);
+				for(auto cursor = from; cursor != it; ++cursor) {
+					results.emplace_back(match.value(*cursor));
+				}
+			} else {
+				while(auto result = match(it, end)) {
+					results.emplace_back(*std::move(result));
+				}
 			}
 			return std::make_optional<value_type>(std::move(results));
 		}
@@ -771,6 +891,10 @@ namespace lib {
 		{
 			return a.match == b.match;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			return nfa.star(match.compile(nfa));
+		}
 	};
 
 	template <class Match>
@@ -826,6 +950,10 @@ namespace lib {
 		{
 			return a.match == b.match;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			return nfa.optional(match.compile(nfa));
+		}
 	};
 
 	template <class Match>
@@ -857,7 +985,17 @@ namespace lib {
 		constexpr result_t operator()(Begin& it, End end) const
 		{
 			value_type results;
-			if(auto result = match(it, end))
+			if constexpr(requires { it = match.skip(it, end); }) {
+				const auto from = it;
+				it = match.skip(it, end);
+				if(it == from)
+					return std::nullopt;
+				for(auto cursor = from; cursor != it; ++cursor) {
+					results.emplace_back(match.value(*cursor));
+				}
+				return std::make_optional<value_type>(std::move(results));
+			}
+			else if(auto result = match(it, end))
 			{
 				results.emplace_back(*std::move(result));
 				while(auto result = match(it, end)) {
@@ -891,6 +1029,10 @@ namespace lib {
 		{
 			return a.match == b.match;
 		}
+		constexpr regex_nfa::fragment compile(regex_nfa& nfa) const
+		{
+			return nfa.plus(match.compile(nfa));
+		}
 	};
 
 	template <class Match>
@@ -899,5 +1041,29 @@ namespace lib {
 		return regex<match_one_plus<regex<Match>>>(std::move(match));
 	}
 
+	/// Сводит составной regex к минимальному ДКА: одно обращение к таблице на символ
+	/// вместо рекурсивного перебора альтернатив. ДКА распознаёт регулярный язык
+	/// выражения и ищет самое длинное совпадение, поэтому принимает и то, что отвергает
+	/// жадный перебор без отката: (*match("a") & match("a"))("aa").
+	template <class Regex>
+	constexpr regex_dfa<> regex_compile(const regex<Regex>& expression)
+	{
+		regex_nfa nfa;
+		return nfa.determinize(expression.compile(nfa));
+	}
+
+	/// Таблица фиксированного размера, которую можно положить в constexpr-переменную:
+	/// constexpr auto identifier = regex_compile([] { return symbol & *(symbol | number); });
+	template <class Factory>
+		requires std::is_invocable_v<const Factory&>
+	constexpr auto regex_compile(const Factory& factory)
+	{
+		constexpr auto shape = [] {
+			const auto dfa = regex_compile(Factory{}());
+			return std::pair{dfa.states(), dfa.classes_count()};
+		}();
+		return regex_dfa<shape.first, shape.second>(regex_compile(factory()));
+	}
+
 }
 #endif
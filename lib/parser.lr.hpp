@@ -0,0 +1,621 @@
+#pragma once
+#include <lib/test.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lib {
+
+	/// Грамматика из текстовых продукций: "E := E + T | T", пустая альтернатива - "A := | b".
+	/// Нетерминалы - все левые части, остальные слова - терминалы.
+	/// Номера символов: терминалы с 0 ("$" - конец входа), за ними нетерминалы
+	/// ("$accept" - пополняющий). Продукция 0 - "$accept := <левая часть первой продукции>".
+	class lr_grammar
+	{
+	public:
+		using symbol_t = std::uint16_t;
+
+		struct production
+		{
+			symbol_t lhs;
+			std::vector<symbol_t> rhs;
+		};
+
+		constexpr static inline std::string_view end = "$";
+		constexpr static inline std::string_view accept = "$accept";
+	public:
+		std::vector<std::string_view> names;
+		std::size_t terminals = 0;
+		std::vector<production> productions;
+	public:
+		constexpr lr_grammar(std::initializer_list<std::string_view> rules)
+		{
+			std::vector<std::string_view> lhs;
+			std::vector<std::string_view> words;
+			for(auto rule: rules) {
+				const auto tokens = split(rule);
+				if(tokens.size() < 2 || tokens[1] != ":=")
+					throw std::invalid_argument("lr_grammar: production must look like 'A := b C'");
+				if(std::find(lhs.begin(), lhs.end(), tokens[0]) == lhs.end())
+					lhs.push_back(tokens[0]);
+				for(std::size_t i = 2; i < tokens.size(); ++i) {
+					if(tokens[i] != "|" && std::find(words.begin(), words.end(), tokens[i]) == words.end())
+						words.push_back(tokens[i]);
+				}
+			}
+			if(lhs.empty())
+				throw std::invalid_argument("lr_grammar: no productions");
+
+			names.push_back(end);
+			for(auto word: words) {
+				if(std::find(lhs.begin(), lhs.end(), word) == lhs.end())
+					names.push_back(word);
+			}
+			terminals = names.size();
+			names.push_back(accept);
+			names.insert(names.end(), lhs.begin(), lhs.end());
+			if(names.size() > std::numeric_limits<symbol_t>::max())
+				throw std::length_error("lr_grammar: too many symbols");
+
+			productions.push_back(production{symbol(accept), {symbol(lhs[0])}});
+			for(auto rule: rules) {
+				const auto tokens = split(rule);
+				production current{symbol(tokens[0]), {}};
+				for(std::size_t i = 2; i < tokens.size(); ++i) {
+					if(tokens[i] == "|") {
+						productions.push_back(std::move(current));
+						current = production{symbol(tokens[0]), {}};
+					} else {
+						current.rhs.push_back(symbol(tokens[i]));
+					}
+				}
+				productions.push_back(std::move(current));
+			}
+		}
+	public:
+		[[nodiscard]] constexpr symbol_t symbol(std::string_view name) const
+		{
+			const auto it = std::find(names.begin(), names.end(), name);
+			if(it == names.end())
+				throw std::out_of_range("lr_grammar: unknown symbol");
+			return static_cast<symbol_t>(it - names.begin());
+		}
+		[[nodiscard]] constexpr bool terminal(symbol_t symbol) const noexcept
+		{
+			return symbol < terminals;
+		}
+	private:
+		constexpr static std::vector<std::string_view> split(std::string_view text)
+		{
+			std::vector<std::string_view> tokens;
+			std::size_t i = 0;
+			while(i < text.size()) {
+				while(i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n'))
+					++i;
+				const auto begin = i;
+				while(i < text.size() && text[i] != ' ' && text[i] != '\t' && text[i] != '\n')
+					++i;
+				if(i != begin)
+					tokens.push_back(text.substr(begin, i - begin));
+			}
+			return tokens;
+		}
+	};
+
+	enum class lr_mode: std::uint8_t
+	{
+		lr1,
+		lalr1,
+	};
+
+	/// Размеры упакованной таблицы: параметр lr_table фиксированного размера.
+	struct lr_shape
+	{
+		std::size_t symbols = 0;
+		std::size_t terminals = 0;
+		std::size_t productions = 0;
+		std::size_t states = 0;
+		std::size_t action_rows = 0;
+		std::size_t goto_rows = 0;
+
+		constexpr bool operator==(const lr_shape&) const noexcept = default;
+	};
+
+	/// Таблицы ACTION/GOTO. Одинаковые строки хранятся один раз, состояние ссылается
+	/// на строку по индексу. Действие - 16 бит: два младших - вид, остальные - аргумент.
+	/// lr_table<> хранит всё в векторах, lr_table<shape> - в массивах и может быть constexpr.
+	template <lr_shape Shape = lr_shape{}>
+	class lr_table
+	{
+		template <lr_shape>
+		friend class lr_table;
+		friend constexpr lr_table<> lr_compile(const lr_grammar& grammar, lr_mode mode);
+	public:
+		using symbol_t = lr_grammar::symbol_t;
+		using entry_t = std::uint16_t;
+
+		enum kind: entry_t
+		{
+			error  = 0,
+			shift  = 1,
+			reduce = 2,
+			accept = 3,
+		};
+
+		constexpr static inline bool fixed = Shape.states != 0;
+	private:
+		template <class T, std::size_t Size>
+		using storage = std::conditional_t<fixed, std::array<T, Size>, std::vector<T>>;
+
+		storage<std::string_view, Shape.symbols> names{};
+		storage<symbol_t, Shape.productions> lhs{};
+		storage<entry_t, Shape.productions> lengths{};
+		storage<entry_t, Shape.states> action_index{};
+		storage<entry_t, Shape.action_rows * Shape.terminals> actions{};
+		storage<entry_t, Shape.states> goto_index{};
+		storage<entry_t, Shape.goto_rows * (Shape.symbols - Shape.terminals)> gotos{};
+		std::size_t terminals = Shape.terminals;
+	public:
+		constexpr lr_table() noexcept = default;
+		template <lr_shape Other>
+			requires (fixed && Other == lr_shape{})
+		constexpr explicit lr_table(const lr_table<Other>& table)
+		: terminals(table.terminals)
+		{
+			if(table.shape() != Shape)
+				throw std::length_error("lr_table: table shape mismatch");
+			std::copy(table.names.begin(), table.names.end(), names.begin());
+			std::copy(table.lhs.begin(), table.lhs.end(), lhs.begin());
+			std::copy(table.lengths.begin(), table.lengths.end(), lengths.begin());
+			std::copy(table.action_index.begin(), table.action_index.end(), action_index.begin());
+			std::copy(table.actions.begin(), table.actions.end(), actions.begin());
+			std::copy(table.goto_index.begin(), table.goto_index.end(), goto_index.begin());
+			std::copy(table.gotos.begin(), table.gotos.end(), gotos.begin());
+		}
+	public:
+		[[nodiscard]] constexpr lr_shape shape() const noexcept
+		{
+			return lr_shape{
+				names.size(),
+				terminals,
+				lhs.size(),
+				action_index.size(),
+				terminals != 0 ? actions.size() / terminals : 0,
+				names.size() != terminals ? gotos.size() / (names.size() - terminals) : 0,
+			};
+		}
+		[[nodiscard]] constexpr std::size_t states() const noexcept
+		{
+			return action_index.size();
+		}
+		[[nodiscard]] constexpr symbol_t symbol(std::string_view name) const
+		{
+			const auto it = std::find(names.begin(), names.end(), name);
+			if(it == names.end())
+				throw std::out_of_range("lr_table: unknown symbol");
+			return static_cast<symbol_t>(it - names.begin());
+		}
+		[[nodiscard]] constexpr std::string_view name(symbol_t symbol) const noexcept
+		{
+			return names[symbol];
+		}
+		[[nodiscard]] constexpr entry_t action(std::size_t state, symbol_t terminal) const noexcept
+		{
+			return actions[action_index[state] * terminals + terminal];
+		}
+		[[nodiscard]] constexpr entry_t go(std::size_t state, symbol_t nonterminal) const noexcept
+		{
+			return gotos[goto_index[state] * (names.size() - terminals) + (nonterminal - terminals)];
+		}
+		[[nodiscard]] constexpr symbol_t production_lhs(std::size_t production) const noexcept
+		{
+			return lhs[production];
+		}
+		[[nodiscard]] constexpr std::size_t production_length(std::size_t production) const noexcept
+		{
+			return lengths[production];
+		}
+	};
+
+	/// Каноническое построение LR(1) по множествам пунктов; в режиме lalr1
+	/// состояния с одинаковым ядром сливаются. Конфликт - исключение std::logic_error,
+	/// при constexpr-построении - ошибка компиляции.
+	constexpr lr_table<> lr_compile(const lr_grammar& grammar, lr_mode mode = lr_mode::lalr1)
+	{
+		using entry_t = lr_table<>::entry_t;
+
+		const std::size_t terminals = grammar.terminals;
+		const std::size_t symbols = grammar.names.size();
+		const std::size_t nonterminals = symbols - terminals;
+		const auto& productions = grammar.productions;
+
+		// FIRST и пустые нетерминалы
+		std::vector<std::uint8_t> nullable(nonterminals, 0);
+		std::vector<std::uint8_t> first(nonterminals * terminals, 0);
+		for(bool changed = true; changed;) {
+			changed = false;
+			for(const auto& p: productions) {
+				const auto a = p.lhs - terminals;
+				bool empty = true;
+				for(auto s: p.rhs) {
+					if(grammar.terminal(s)) {
+						changed |= first[a * terminals + s] == 0;
+						first[a * terminals + s] = 1;
+						empty = false;
+						break;
+					}
+					for(std::size_t t = 0; t < terminals; ++t) {
+						if(first[(s - terminals) * terminals + t] != 0 && first[a * terminals + t] == 0) {
+							first[a * terminals + t] = 1;
+							changed = true;
+						}
+					}
+					if(nullable[s - terminals] == 0) {
+						empty = false;
+						break;
+					}
+				}
+				if(empty && nullable[a] == 0) {
+					nullable[a] = 1;
+					changed = true;
+				}
+			}
+		}
+
+		struct item
+		{
+			std::uint16_t production;
+			std::uint16_t dot;
+			std::uint16_t lookahead;
+
+			constexpr bool operator==(const item&) const noexcept = default;
+			constexpr bool operator<(const item& other) const noexcept
+			{
+				if(production != other.production)
+					return production < other.production;
+				if(dot != other.dot)
+					return dot < other.dot;
+				return lookahead < other.lookahead;
+			}
+		};
+
+		// пункт (production, dot, lookahead) -> номер для отметок при замыкании
+		std::vector<std::size_t> base(productions.size() + 1, 0);
+		for(std::size_t p = 0; p < productions.size(); ++p)
+			base[p + 1] = base[p] + productions[p].rhs.size() + 1;
+		std::vector<std::uint32_t> marks(base.back() * terminals, 0);
+		std::uint32_t stamp = 0;
+		const auto slot = [&](const item& i) {
+			return (base[i.production] + i.dot) * terminals + i.lookahead;
+		};
+
+		std::vector<std::uint8_t> lookaheads(terminals);
+		const auto closure = [&](std::vector<item>& set) {
+			++stamp;
+			for(const auto& i: set)
+				marks[slot(i)] = stamp;
+			for(std::size_t k = 0; k < set.size(); ++k) {
+				const auto current = set[k];
+				const auto& rhs = productions[current.production].rhs;
+				if(current.dot >= rhs.size() || grammar.terminal(rhs[current.dot]))
+					continue;
+				// FIRST(beta lookahead)
+				std::fill(lookaheads.begin(), lookaheads.end(), 0);
+				bool rest = true;
+				for(std::size_t d = current.dot + 1; d < rhs.size() && rest; ++d) {
+					const auto s = rhs[d];
+					if(grammar.terminal(s)) {
+						lookaheads[s] = 1;
+						rest = false;
+					} else {
+						for(std::size_t t = 0; t < terminals; ++t)
+							lookaheads[t] |= first[(s - terminals) * terminals + t];
+						rest = nullable[s - terminals] != 0;
+					}
+				}
+				if(rest)
+					lookaheads[current.lookahead] = 1;
+				for(std::size_t p = 0; p < productions.size(); ++p) {
+					if(productions[p].lhs != rhs[current.dot])
+						continue;
+					for(std::size_t t = 0; t < terminals; ++t) {
+						const item next{static_cast<std::uint16_t>(p), 0, static_cast<std::uint16_t>(t)};
+						if(lookaheads[t] != 0 && marks[slot(next)] != stamp) {
+							marks[slot(next)] = stamp;
+							set.push_back(next);
+						}
+					}
+				}
+			}
+			std::sort(set.begin(), set.end());
+		};
+
+		std::vector<std::vector<item>> states;
+		std::vector<std::size_t> transitions;
+		{
+			std::vector<item> initial{item{0, 0, 0}};
+			closure(initial);
+			states.push_back(std::move(initial));
+		}
+		for(std::size_t s = 0; s < states.size(); ++s) {
+			for(std::size_t x = 0; x < symbols; ++x) {
+				std::vector<item> target;
+				for(const auto& i: states[s]) {
+					const auto& rhs = productions[i.production].rhs;
+					if(i.dot < rhs.size() && rhs[i.dot] == x)
+						target.push_back(item{i.production, static_cast<std::uint16_t>(i.dot + 1), i.lookahead});
+				}
+				if(target.empty()) {
+					transitions.push_back(0);
+					continue;
+				}
+				closure(target);
+				const auto found = std::find(states.begin(), states.end(), target);
+				transitions.push_back(static_cast<std::size_t>(found - states.begin()));
+				if(found == states.end())
+					states.push_back(std::move(target));
+			}
+		}
+
+		// LALR: одно состояние на ядро, предпросмотры объединяются
+		std::vector<std::size_t> merged(states.size());
+		std::vector<std::vector<item>> result;
+		{
+			const auto core = [](const std::vector<item>& set) {
+				std::vector<std::pair<std::uint16_t, std::uint16_t>> points;
+				for(const auto& i: set) {
+					if(points.empty() || points.back() != std::pair{i.production, i.dot})
+						points.emplace_back(i.production, i.dot);
+				}
+				return points;
+			};
+			std::vector<std::vector<std::pair<std::uint16_t, std::uint16_t>>> cores;
+			for(std::size_t s = 0; s < states.size(); ++s) {
+				auto points = core(states[s]);
+				auto found = mode == lr_mode::lalr1 ? std::find(cores.begin(), cores.end(), points) : cores.end();
+				merged[s] = static_cast<std::size_t>(found - cores.begin());
+				if(found == cores.end()) {
+					cores.push_back(std::move(points));
+					result.push_back(states[s]);
+				} else {
+					auto& set = result[merged[s]];
+					set.insert(set.end(), states[s].begin(), states[s].end());
+					std::sort(set.begin(), set.end());
+					set.erase(std::unique(set.begin(), set.end()), set.end());
+				}
+			}
+		}
+		if(result.size() >= (std::size_t(1) << 14U))
+			throw std::length_error("lr_compile: too many states");
+
+		const auto encode = [](entry_t kind, std::size_t value) {
+			return static_cast<entry_t>(value << 2U | kind);
+		};
+		std::vector<entry_t> actions(result.size() * terminals, lr_table<>::error);
+		std::vector<entry_t> gotos(result.size() * nonterminals, 0);
+		for(std::size_t s = 0; s < states.size(); ++s) {
+			const auto m = merged[s];
+			for(std::size_t x = 0; x < symbols; ++x) {
+				const auto target = transitions[s * symbols + x];
+				if(target == 0)
+					continue;
+				if(x < terminals)
+					actions[m * terminals + x] = encode(lr_table<>::shift, merged[target]);
+				else
+					gotos[m * nonterminals + (x - terminals)] = static_cast<entry_t>(merged[target]);
+			}
+		}
+		for(std::size_t m = 0; m < result.size(); ++m) {
+			for(const auto& i: result[m]) {
+				if(i.dot != productions[i.production].rhs.size())
+					continue;
+				auto& cell = actions[m * terminals + i.lookahead];
+				const auto next = i.production == 0 ? entry_t(lr_table<>::accept) : encode(lr_table<>::reduce, i.production);
+				if(cell != lr_table<>::error && cell != next) {
+					throw std::logic_error((cell & 3U) == lr_table<>::shift
+						? "lr_compile: shift/reduce conflict"
+						: "lr_compile: reduce/reduce conflict");
+				}
+				cell = next;
+			}
+		}
+
+		// упаковка: одинаковые строки хранятся один раз
+		const auto pack = [](const std::vector<entry_t>& table, std::size_t width, std::vector<entry_t>& index, std::vector<entry_t>& rows) {
+			const std::size_t count = width != 0 ? table.size() / width : 0;
+			for(std::size_t r = 0; r < count; ++r) {
+				std::size_t found = 0;
+				const auto row = table.begin() + static_cast<std::ptrdiff_t>(r * width);
+				const auto packed = rows.size() / width;
+				while(found < packed && !std::equal(row, row + static_cast<std::ptrdiff_t>(width), rows.begin() + static_cast<std::ptrdiff_t>(found * width)))
+					++found;
+				if(found == packed)
+					rows.insert(rows.end(), row, row + static_cast<std::ptrdiff_t>(width));
+				index.push_back(static_cast<entry_t>(found));
+			}
+		};
+
+		lr_table<> table;
+		table.terminals = terminals;
+		table.names.assign(grammar.names.begin(), grammar.names.end());
+		for(const auto& p: productions) {
+			table.lhs.push_back(p.lhs);
+			table.lengths.push_back(static_cast<entry_t>(p.rhs.size()));
+		}
+		pack(actions, terminals, table.action_index, table.actions);
+		pack(gotos, nonterminals, table.goto_index, table.gotos);
+		return table;
+	}
+
+	/// Таблица фиксированного размера для constexpr-переменной:
+	/// constexpr auto table = lr_compile([] { return lr_grammar{"E := E + id | id"}; });
+	template <lr_mode Mode = lr_mode::lalr1, class Factory>
+		requires std::is_invocable_r_v<lr_grammar, const Factory&>
+	constexpr auto lr_compile(const Factory& factory)
+	{
+		constexpr auto shape = lr_compile(Factory{}(), Mode).shape();
+		return lr_table<shape>(lr_compile(factory(), Mode));
+	}
+
+	/// Нерекурсивный shift/reduce-разбор по таблице. Лексемы подаются по одной
+	/// через push(), поэтому разбор можно вести прямо из regex_stream.
+	/// reduce(production, std::span<Value> rhs) -> Value строит значение нетерминала.
+	template <class Value, class Table>
+	class lr_parser
+	{
+		using symbol_t = lr_grammar::symbol_t;
+		using entry_t = std::uint16_t;
+
+		const Table* table;
+		std::vector<entry_t> stack{0};
+		std::vector<Value> values;
+		bool accepted = false;
+		bool failed = false;
+	public:
+		explicit lr_parser(const Table& table) noexcept
+		: table(&table)
+		{}
+	public:
+		/// Очередной терминал со значением; false - синтаксическая ошибка.
+		template <class Reduce>
+		bool push(symbol_t terminal, Value value, Reduce&& reduce)
+		{
+			if(!advance(terminal, reduce) || accepted) {
+				failed = true;
+				return false;
+			}
+			stack.push_back(static_cast<entry_t>(table->action(stack.back(), terminal) >> 2U));
+			values.push_back(std::move(value));
+			return true;
+		}
+		/// Конец входа: значение стартового символа или nullopt при ошибке.
+		template <class Reduce>
+		std::optional<Value> finish(Reduce&& reduce)
+		{
+			if(failed || !advance(0, reduce) || !accepted)
+				return std::nullopt;
+			return std::make_optional<Value>(std::move(values.back()));
+		}
+		[[nodiscard]] bool error() const noexcept
+		{
+			return failed;
+		}
+		/// Глубина стека состояний.
+		[[nodiscard]] std::size_t depth() const noexcept
+		{
+			return stack.size();
+		}
+	private:
+		/// Свёртки до сдвига terminal или принятия входа.
+		template <class Reduce>
+		bool advance(symbol_t terminal, Reduce& reduce)
+		{
+			if(failed)
+				return false;
+			for(;;) {
+				const auto action = table->action(stack.back(), terminal);
+				switch(action & 3U) {
+				case Table::shift:
+					return true;
+				case Table::accept:
+					accepted = true;
+					return true;
+				case Table::reduce: {
+					const std::size_t production = action >> 2U;
+					const auto length = table->production_length(production);
+					const auto first = values.end() - static_cast<std::ptrdiff_t>(length);
+					Value value = reduce(production, std::span<Value>(first, values.end()));
+					values.erase(first, values.end());
+					stack.resize(stack.size() - length);
+					stack.push_back(table->go(stack.back(), table->production_lhs(production)));
+					values.push_back(std::move(value));
+					break;
+				}
+				default:
+					failed = true;
+					return false;
+				}
+			}
+		}
+	};
+
+	unittest {
+		// S := C C; C := c C | d: канонический LR(1) - 10 состояний, LALR(1) - 7
+		const lr_grammar grammar{
+			"S := C C",
+			"C := c C | d",
+		};
+		check(grammar.terminals == 3 && grammar.productions.size() == 4);
+		check(lr_compile(grammar, lr_mode::lr1).states() == 10);
+		check(lr_compile(grammar, lr_mode::lalr1).states() == 7);
+
+		const auto table = lr_compile(grammar);
+		const auto c = table.symbol("c");
+		const auto d = table.symbol("d");
+		lr_parser<int, lr_table<>> parser(table);
+		const auto count = [](std::size_t, std::span<int> values) {
+			int sum = 0;
+			for(auto value: values)
+				sum += value;
+			return sum;
+		};
+		check(parser.push(c, 1, count) && parser.push(d, 1, count) && parser.push(c, 1, count));
+		check(parser.push(c, 1, count) && parser.push(d, 1, count));
+		check(parser.finish(count) == 5);
+
+		lr_parser<int, lr_table<>> broken(table);
+		check(broken.push(d, 1, count) && !broken.push(table.symbol("$"), 0, count) && broken.error());
+
+		bool conflict = false;
+		try {
+			(void)lr_compile(lr_grammar{"E := E + E | id"});
+		} catch(const std::logic_error&) {
+			conflict = true;
+		}
+		check(conflict);
+	}
+
+	unittest {
+		constexpr auto table = lr_compile([] {
+			return lr_grammar{
+				"E := E + T | T",
+				"T := T * F | F",
+				"F := ( E ) | id",
+				"A := | A x",
+			};
+		});
+		static_assert(table.shape().states != 0);
+		static_assert(table.shape().action_rows < table.states());
+
+		// id * ( id + id ) + id, значения id: 2, 3, 4, 5
+		constexpr auto id = table.symbol("id");
+		const std::pair<lr_grammar::symbol_t, long> input[] = {
+			{id, 2}, {table.symbol("*"), 0}, {table.symbol("("), 0}, {id, 3}, {table.symbol("+"), 0},
+			{id, 4}, {table.symbol(")"), 0}, {table.symbol("+"), 0}, {id, 5},
+		};
+		const auto evaluate = [&](std::size_t production, std::span<long> rhs) -> long {
+			switch(production) {
+			case 1: return rhs[0] + rhs[2];
+			case 3: return rhs[0] * rhs[2];
+			case 5: return rhs[1];
+			default: return rhs.empty() ? 0 : rhs[0];
+			}
+		};
+		lr_parser<long, std::remove_const_t<decltype(table)>> parser(table);
+		bool pushed = true;
+		for(const auto& [terminal, value]: input)
+			pushed = pushed && parser.push(terminal, value, evaluate);
+		check(pushed);
+		check(parser.finish(evaluate) == 2 * (3 + 4) + 5);
+	}
+}
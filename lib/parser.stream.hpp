@@ -0,0 +1,168 @@
+#pragma once
+#include <lib/buffer.chain.hpp>
+#include <lib/parser.dfa.hpp>
+#include <lib/test.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lib {
+
+	/// Разбор потока блоков Owner<const char> на лексемы по ДКА regex_compile:
+	/// состояние автомата переживает границу блока, так что лексема, разрезанная
+	/// между блоками, дочитывается из следующего. Блоки не склеиваются - лексема
+	/// отдаётся как buffer::Chain из долей исходных блоков, а память ограничена
+	/// блоками, на которые приходится незавершённая лексема.
+	/// Лексемы выделяются по самому длинному совпадению; пустые не выдаются.
+	template <class Dfa>
+	class regex_stream
+	{
+	public:
+		using token = buffer::Chain<const char>;
+	private:
+		using state_t = typename Dfa::state_t;
+
+		const Dfa* dfa;
+		token pending;
+		std::size_t scanned = 0;
+		std::size_t accepted = 0;
+		state_t state;
+		bool failed = false;
+	public:
+		explicit regex_stream(const Dfa& dfa) noexcept
+		: dfa(&dfa)
+		, state(dfa.initial())
+		{}
+	public:
+		/// Продолжает разбор блоком chunk; on_token(token&&) вызывается для каждой
+		/// завершённой лексемы. false - начало непрочитанного остатка не совпадает ни с чем.
+		template <class Callback>
+		bool feed(buffer::Owner<const char> chunk, Callback&& on_token)
+		{
+			if(failed)
+				return false;
+			pending.append(std::move(chunk));
+			return scan(on_token, false);
+		}
+		/// Конец входа: отдаёт последнюю лексему. false - если в хвосте осталось несовпавшее.
+		template <class Callback>
+		bool finish(Callback&& on_token)
+		{
+			if(failed)
+				return false;
+			return scan(on_token, true) && pending.empty();
+		}
+		/// Разбирает последовательность блоков целиком, например очередь из канала.
+		template <class Chunks, class Callback>
+		bool parse(Chunks&& chunks, Callback&& on_token)
+		{
+			for(auto&& chunk: chunks) {
+				if(!feed(buffer::Owner<const char>(std::forward<decltype(chunk)>(chunk)), on_token))
+					return false;
+			}
+			return finish(on_token);
+		}
+		/// Число байтов незавершённой лексемы, которые держит поток.
+		[[nodiscard]] std::size_t buffered() const noexcept
+		{
+			return pending.size();
+		}
+		[[nodiscard]] bool error() const noexcept
+		{
+			return failed;
+		}
+	private:
+		template <class Callback>
+		bool scan(Callback& on_token, bool last)
+		{
+			for(;;) {
+				std::size_t offset = 0;
+				for(const auto& segment: pending) {
+					if(state == Dfa::dead)
+						break;
+					if(scanned >= offset + segment.size()) {
+						offset += segment.size();
+						continue;
+					}
+					const char* data = segment.data();
+					for(std::size_t i = scanned - offset; i < segment.size(); ++i) {
+						state = dfa->next(state, static_cast<unsigned char>(data[i]));
+						++scanned;
+						if(state == Dfa::dead)
+							break;
+						if(dfa->accepting(state))
+							accepted = scanned;
+					}
+					offset += segment.size();
+				}
+				// лексема может продолжиться в следующем блоке
+				if(state != Dfa::dead && (!last || pending.empty()))
+					return true;
+				if(accepted == 0) {
+					failed = true;
+					return false;
+				}
+				on_token(pending.split(accepted));
+				scanned = 0;
+				accepted = 0;
+				state = dfa->initial();
+				if(pending.empty())
+					return true;
+			}
+		}
+	};
+
+	unittest {
+		// [a-z]+ | [0-9]+ | пробелы
+		regex_nfa nfa;
+		const regex_nfa::fragment root{nfa.state(), nfa.state()};
+		const regex_nfa::fragment word{nfa.state(), nfa.state()};
+		const regex_nfa::fragment number{nfa.state(), nfa.state()};
+		const regex_nfa::fragment space{nfa.state(), nfa.state()};
+		nfa.range(word.begin, word.end, 'a', 'z');
+		nfa.range(number.begin, number.end, '0', '9');
+		nfa.symbol(space.begin, space.end, ' ');
+		for(auto fragment: {nfa.plus(word), nfa.plus(number), nfa.plus(space)}) {
+			nfa.epsilon(root.begin, fragment.begin);
+			nfa.epsilon(fragment.end, root.end);
+		}
+		const auto dfa = nfa.determinize(root);
+
+		const auto text = [](const buffer::Chain<const char>& chain) {
+			std::string result(chain.size(), '\0');
+			chain.copy(buffer::ViewImpl<char>(result.data(), result.size()));
+			return result;
+		};
+
+		std::vector<std::string> tokens;
+		regex_stream stream(dfa);
+		const auto collect = [&](buffer::Chain<const char>&& token) {
+			tokens.push_back(text(token));
+		};
+		check(stream.feed("hel", collect) && tokens.empty());
+		check(stream.buffered() == 3);
+		check(stream.feed("lo 12", collect) && tokens.size() == 2);
+		check(stream.feed("", collect));
+		check(stream.feed("34world", collect) && tokens.size() == 3);
+		check(stream.finish(collect));
+		check((tokens == std::vector<std::string>{"hello", " ", "1234", "world"}));
+
+		// лексема, склеенная из одиночных байтов, остаётся цепочкой сегментов
+		std::size_t segments = 0;
+		regex_stream bytes(dfa);
+		check(bytes.parse(std::vector<std::string_view>{"a", "b", "c", "1"}, [&](buffer::Chain<const char>&& token) {
+			segments = std::max(segments, token.segments_count());
+		}));
+		check(segments == 3);
+
+		regex_stream broken(dfa);
+		tokens.clear();
+		check(broken.feed("ab", collect));
+		check(!broken.feed("c-d", collect) && broken.error());
+		check((tokens == std::vector<std::string>{"abc"}));
+		check(!broken.feed("e", collect) && !broken.finish(collect));
+	}
+}
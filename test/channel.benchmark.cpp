@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <lib/buffered.channel.hpp>
+#include <chrono>
+#include <future>
+#include <iostream>
+
+namespace {
+    constexpr std::size_t count = 1 << 22;
+    using Channel = lib::BufferedChannel<std::size_t, 1024>;
+
+    template <class Function>
+    void benchmark(const char* name, Function&& consume)
+    {
+        Channel channel;
+        auto producer = std::async(
+            std::launch::async,
+            [&channel] {
+                for(std::size_t i = 0; i < count; ++i) {
+                    channel.send(i);
+                }
+                channel.close();
+            }
+        );
+
+        auto start = std::chrono::steady_clock::now();
+        std::size_t sum = consume(channel);
+        auto time = std::chrono::steady_clock::now() - start;
+        producer.get();
+
+        EXPECT_EQ(sum, count * (count - 1) / 2);
+        std::cout << name << ": "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() / count << " ns/msg" << std::endl;
+    }
+}
+
+TEST(lib, DISABLED_benchmark_channel_concrete)
+{
+    benchmark("concrete", [](Channel& channel) {
+        std::size_t sum = 0;
+        for(const auto& chunk: lib::ibatch(channel)) {
+            for(auto value: chunk) {
+                sum += value;
+            }
+        }
+        return sum;
+    });
+}
+
+TEST(lib, DISABLED_benchmark_channel_erased)
+{
+    benchmark("erased", [](Channel& channel) {
+        lib::VIChannel ichannel = channel;
+        lib::Subscriber subscriber(ichannel.event());
+        std::size_t sum = 0;
+        while(lib::wait(subscriber, ichannel)) {
+            sum += ichannel.peek();
+            ichannel.next();
+        }
+        return sum;
+    });
+}
+
+TEST(lib, DISABLED_benchmark_channel_erased_batch)
+{
+    benchmark("erased batch", [](Channel& channel) {
+        lib::VIChannel ichannel = channel;
+        std::size_t buffer[256];
+        std::size_t sum = 0;
+        while(auto size = ichannel.recv(lib::Span<std::size_t>(buffer))) {
+            for(std::size_t i = 0; i < size; ++i) {
+                sum += buffer[i];
+            }
+        }
+        return sum;
+    });
+}
@@ -2,8 +2,11 @@
 #include <lib/buffered.channel.hpp>
 #include <lib/aggregate.channel.hpp>
 #include <lib/broadcast.channel.hpp>
+#include <lib/adaptor.channel.hpp>
+#include <lib/buffered.stream.hpp>
 #include <thread>
 #include <future>
+#include <numeric>
 
 TEST(lib, buffered_channel_base)
 {
@@ -258,19 +261,22 @@ TEST(lib, buffered_channel_mux_mux_all)
 
 TEST(lib, broadcast_channel)
 {
-    lib::BufferedChannel<int, 2> channels[3];
-    lib::BroadCastChannel channel(channels[0], channels[1], channels[2]);
+    using Channel = lib::BroadcastChannel<int, 2>;
+    Channel channel;
     std::vector<int> values[3];
-    auto worker = [](lib::VIChannel<int> ichannel, std::vector<int>& output)
+    auto worker = [](Channel::Reader& reader, std::vector<int>& output)
     {
-        for(auto value: lib::irange(ichannel)) {
-            output.push_back(value);
+        lib::Subscriber subscriber(reader.event());
+        while(lib::wait(subscriber, reader)) {
+            output.push_back(reader.peek());
+            reader.next();
         }
     };
+    Channel::Reader readers[3] = {Channel::Reader(channel), Channel::Reader(channel), Channel::Reader(channel)};
     std::array threads = {
-        std::async(worker, lib::VIChannel(channels[0]), std::ref(values[0])),
-        std::async(worker, lib::VIChannel(channels[1]), std::ref(values[1])),
-        std::async(worker, lib::VIChannel(channels[2]), std::ref(values[2]))
+        std::async(worker, std::ref(readers[0]), std::ref(values[0])),
+        std::async(worker, std::ref(readers[1]), std::ref(values[1])),
+        std::async(worker, std::ref(readers[2]), std::ref(values[2]))
     };
     channel.send(1);
     channel.send(2);
@@ -285,6 +291,19 @@ TEST(lib, broadcast_channel)
     EXPECT_EQ(values[2], (std::vector<int>{1, 2, 3, 4}));
 }
 
+TEST(lib, broadcast_channel_drop_oldest)
+{
+    using Channel = lib::BroadcastChannel<int, 2, lib::BroadcastGating::DropOldest>;
+    Channel channel;
+    Channel::Reader reader(channel);
+    for(int i = 0; i < 5; ++i) {
+        channel.send(i);
+    }
+    ASSERT_EQ(reader.poll(), 2);
+    EXPECT_EQ(reader.lost(), 3);
+    EXPECT_EQ(reader.peek(), 3);
+}
+
 TEST(lib, aggregate_channel)
 {
     lib::BufferedChannel<int, 2> channels[3];
@@ -311,3 +330,212 @@ TEST(lib, aggregate_channel)
         thread.get();
     }
 }
+
+TEST(lib, channel_select_priority)
+{
+    lib::BufferedChannel<int, 16> control;
+    lib::BufferedChannel<int, 16> heavy;
+    lib::BufferedChannel<int, 16> light;
+    lib::ChannelSelect select(
+        lib::select_source(control, 1),
+        lib::select_source(heavy, 0, 3),
+        lib::select_source(light, 0, 1)
+    );
+    for(int i = 0; i < 8; ++i) {
+        heavy.send(i);
+        light.send(i);
+    }
+    control.send(-1);
+    control.send(-2);
+
+    std::vector<std::size_t> order;
+    while(select.poll() && order.size() < 10) {
+        order.push_back(select.index());
+        select.next();
+    }
+    EXPECT_EQ(order, (std::vector<std::size_t>{0, 0, 1, 1, 2, 1, 1, 1, 2, 1}));
+}
+
+TEST(lib, channel_select_starvation)
+{
+    lib::BufferedChannel<int, 16> control;
+    lib::BufferedChannel<int, 16> data;
+    lib::ChannelSelect select(
+        lib::select_source(control, 1),
+        lib::select_source(data, 0, 1, 2)
+    );
+    for(int i = 0; i < 6; ++i) {
+        control.send(i);
+    }
+    data.send(100);
+
+    std::vector<int> values;
+    while(select.poll()) {
+        std::visit([&](int value) { values.push_back(value); }, select.peek());
+        select.next();
+    }
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 100, 2, 3, 4, 5}));
+}
+
+TEST(lib, virtual_channel_batch)
+{
+    lib::BufferedChannel<int, 8> channel;
+    auto result = std::async(
+        [](lib::VOChannel<int> ochannel) {
+            std::vector<int> values(100);
+            std::iota(values.begin(), values.end(), 0);
+            EXPECT_EQ(ochannel.send(lib::Span<int>(values)), 100);
+            ochannel.close();
+        },
+        lib::VOChannel<int>(channel)
+    );
+    lib::VIChannel ichannel = channel;
+    std::vector<int> values;
+    int buffer[16];
+    while(auto count = ichannel.recv(lib::Span<int>(buffer))) {
+        ASSERT_LE(count, 16);
+        values.insert(values.end(), buffer, buffer + count);
+    }
+    result.get();
+
+    std::vector<int> expected(100);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(values, expected);
+}
+
+TEST(lib, channel_adaptors)
+{
+    lib::BufferedChannel<int, 8> input;
+    auto result = std::async(
+        [&input] {
+            for(int i = 0; i < 100; ++i) {
+                input.send(i);
+            }
+            input.close();
+        }
+    );
+    int calls = 0;
+    auto pipeline = lib::chunk<16>(
+        lib::filter(
+            lib::map(input, [&calls](int value) { ++calls; return value * 3; }),
+            [](int value) { return value % 2 == 0; }
+        )
+    );
+    std::vector<int> values;
+    std::vector<std::size_t> sizes;
+    lib::Subscriber subscriber(pipeline.event());
+    while(lib::wait(subscriber, pipeline)) {
+        auto chunk = pipeline.peek();
+        sizes.push_back(chunk.size());
+        values.insert(values.end(), chunk.begin(), chunk.end());
+        pipeline.next();
+    }
+    result.get();
+
+    std::vector<int> expected;
+    for(int i = 0; i < 100; i += 2) {
+        expected.push_back(i * 3);
+    }
+    EXPECT_EQ(values, expected);
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{16, 16, 16, 2}));
+    // функция map() вызывается один раз на сообщение, в том числе для прошедших фильтр
+    EXPECT_EQ(calls, 100);
+}
+
+TEST(lib, channel_zip)
+{
+    lib::BufferedChannel<int, 4> numbers;
+    lib::BufferedChannel<char, 4> letters;
+    auto zip = lib::zip(numbers, letters);
+    numbers.send(1);
+    numbers.send(2);
+    letters.send('a');
+    ASSERT_EQ(zip.poll(), 1);
+    EXPECT_EQ(zip.peek(), std::make_tuple(1, 'a'));
+    zip.next();
+    EXPECT_EQ(zip.poll(), 0);
+    letters.send('b');
+    ASSERT_EQ(zip.poll(), 1);
+    EXPECT_EQ(zip.peek(), std::make_tuple(2, 'b'));
+}
+
+TEST(lib, buffered_stream)
+{
+    using Stream = lib::BufferedStream<2, 16>;
+    Stream stream;
+    std::vector<std::byte> input(1000);
+    for(std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = std::byte(i * 7);
+    }
+    auto result = std::async(
+        [&] {
+            Stream::Writer writer(stream);
+            for(std::size_t i = 0; i < input.size(); i += 10) {
+                writer.write(lib::buffer::ViewImpl<const std::byte>(input.data() + i, 10));
+            }
+            writer.close();
+        }
+    );
+    Stream::Reader reader(stream);
+    std::vector<std::byte> output;
+    while(true) {
+        auto view = reader.peek(12);
+        if(view.empty()) {
+            break;
+        }
+        output.insert(output.end(), view.begin(), view.end());
+        reader.consume(view.size());
+    }
+    result.get();
+    EXPECT_EQ(output, input);
+    EXPECT_TRUE(reader.closed());
+}
+
+TEST(lib, buffered_stream_reader_gone)
+{
+    using Stream = lib::BufferedStream<2, 16>;
+    Stream stream;
+    std::vector<std::byte> input(1000, std::byte(1));
+    auto result = std::async(
+        [&] {
+            Stream::Writer writer(stream);
+            bool written = true;
+            for(std::size_t i = 0; i < input.size() && written; i += 10) {
+                written = writer.write(lib::buffer::ViewImpl<const std::byte>(input.data() + i, 10));
+            }
+            return written;
+        }
+    );
+    {
+        Stream::Reader reader(stream);
+        auto view = reader.peek(4);
+        EXPECT_EQ(view.size(), 4);
+    }
+    // писатель не зависает и не выделяет блоки сверх 2 * N + 2
+    EXPECT_FALSE(result.get());
+}
+
+TEST(lib, buffered_channel_batch_range)
+{
+    lib::BufferedChannel<int, 4> channel;
+    auto result = std::async(
+        [&channel] {
+            for(int i = 0; i < 64; ++i) {
+                channel.send(i);
+            }
+            channel.close();
+        }
+    );
+    std::vector<int> values;
+    for(const auto& chunk: lib::ibatch(channel)) {
+        ASSERT_FALSE(chunk.empty());
+        ASSERT_LE(chunk.size(), 4);
+        values.insert(values.end(), chunk.begin(), chunk.end());
+    }
+    result.get();
+
+    std::vector<int> expected(64);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(values, expected);
+    EXPECT_EQ(channel.poll(), 0);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <lib/lockfree/concurrent.map.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    constexpr std::size_t keys = 1 << 16;
+    constexpr std::size_t operations = 1 << 20;
+
+    /// Для сравнения: одна таблица под std::shared_mutex.
+    class LockedMap
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::uint64_t, std::uint64_t> map;
+    public:
+        std::optional<std::uint64_t> get(std::uint64_t key) const
+        {
+            std::shared_lock lock(mutex);
+            auto it = map.find(key);
+            return it == map.end() ? std::nullopt : std::optional(it->second);
+        }
+        void insert_or_assign(std::uint64_t key, std::uint64_t value)
+        {
+            std::unique_lock lock(mutex);
+            map.insert_or_assign(key, value);
+        }
+        bool erase(std::uint64_t key)
+        {
+            std::unique_lock lock(mutex);
+            return map.erase(key) != 0;
+        }
+    };
+
+    /// Каждый поток делает operations операций: 90% чтений, 10% записей.
+    template <class Map>
+    void benchmark(const char* name)
+    {
+        const auto max_threads = std::max(1U, std::thread::hardware_concurrency());
+        std::cout << name << std::endl;
+        for(unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            Map map;
+            for(std::uint64_t key = 0; key < keys; ++key) {
+                map.insert_or_assign(key, key);
+            }
+            std::vector<std::thread> workers;
+            std::atomic<std::uint64_t> found = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned thread = 0; thread < threads; ++thread) {
+                workers.emplace_back([&map, &found, thread] {
+                    std::mt19937_64 random(thread);
+                    std::uint64_t hits = 0;
+                    for(std::size_t i = 0; i < operations; ++i) {
+                        const auto value = random();
+                        const auto key = value % keys;
+                        if(value % 10 == 0) {
+                            map.insert_or_assign(key, value);
+                        } else {
+                            hits += map.get(key).has_value() ? 1 : 0;
+                        }
+                    }
+                    found += hits;
+                });
+            }
+            for(auto& worker: workers) {
+                worker.join();
+            }
+            auto time = std::chrono::steady_clock::now() - start;
+            const auto total = static_cast<double>(operations) * threads;
+            EXPECT_GT(found.load(), 0U);
+            std::cout << "  threads " << threads << ": "
+                << total / std::chrono::duration<double, std::micro>(time).count() << " Mops/s" << std::endl;
+        }
+    }
+
+    /// Только чтения в threads потоках (не меньше 8, даже на машине с меньшим числом
+    /// ядер), пока один писатель вставляет и удаляет ключи вне читаемого диапазона,
+    /// заставляя части пересобирать таблицы.
+    template <class Map>
+    void benchmark_readers(const char* name)
+    {
+        const auto max_threads = std::max(8U, std::thread::hardware_concurrency());
+        std::cout << name << std::endl;
+        for(unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            Map map;
+            for(std::uint64_t key = 0; key < keys; ++key) {
+                map.insert_or_assign(key, key);
+            }
+            std::atomic_bool stop = false;
+            std::thread writer([&map, &stop] {
+                for(std::uint64_t key = keys; !stop.load(std::memory_order_relaxed); ++key) {
+                    map.insert_or_assign(key, key);
+                    map.erase(key);
+                }
+            });
+            std::vector<std::thread> readers;
+            std::atomic<std::uint64_t> found = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned thread = 0; thread < threads; ++thread) {
+                readers.emplace_back([&map, &found, thread] {
+                    std::mt19937_64 random(thread);
+                    std::uint64_t hits = 0;
+                    for(std::size_t i = 0; i < operations; ++i) {
+                        hits += map.get(random() % keys).has_value() ? 1 : 0;
+                    }
+                    found += hits;
+                });
+            }
+            for(auto& reader: readers) {
+                reader.join();
+            }
+            auto time = std::chrono::steady_clock::now() - start;
+            stop = true;
+            writer.join();
+            const auto total = static_cast<double>(operations) * threads;
+            EXPECT_EQ(found.load(), total);
+            std::cout << "  readers " << threads << ": "
+                << total / std::chrono::duration<double, std::micro>(time).count() << " Mops/s" << std::endl;
+        }
+    }
+}
+
+TEST(lib, DISABLED_benchmark_concurrent_map)
+{
+    benchmark<lib::lockfree::ConcurrentMap<std::uint64_t, std::uint64_t>>("ConcurrentMap");
+}
+
+TEST(lib, DISABLED_benchmark_shared_mutex_map)
+{
+    benchmark<LockedMap>("std::unordered_map + std::shared_mutex");
+}
+
+TEST(lib, DISABLED_benchmark_concurrent_map_readers)
+{
+    benchmark_readers<lib::lockfree::ConcurrentMap<std::uint64_t, std::uint64_t>>("ConcurrentMap, readers + 1 writer");
+}
+
+TEST(lib, DISABLED_benchmark_shared_mutex_map_readers)
+{
+    benchmark_readers<LockedMap>("std::unordered_map + std::shared_mutex, readers + 1 writer");
+}
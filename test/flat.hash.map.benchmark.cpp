@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <lib/data-structures/flat.hash.map.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    constexpr std::size_t count = 1 << 20;
+
+    std::vector<std::uint64_t> keys(std::uint64_t seed)
+    {
+        std::mt19937_64 random(seed);
+        std::vector<std::uint64_t> result(count);
+        for(auto& key: result) {
+            key = random();
+        }
+        return result;
+    }
+
+    template <class Function>
+    void measure(const char* name, Function&& function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const auto result = function();
+        auto time = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() / count << " ns/op"
+            << " (" << result << ")" << std::endl;
+    }
+
+    template <class Map>
+    void benchmark(const char* name)
+    {
+        const auto present = keys(1);
+        const auto absent = keys(2);
+        Map map;
+        std::cout << name << std::endl;
+        measure("  insert", [&] {
+            for(auto key: present) {
+                map[key] = key;
+            }
+            return map.size();
+        });
+        measure("  find hit", [&] {
+            std::uint64_t sum = 0;
+            for(auto key: present) {
+                sum += map.find(key)->second;
+            }
+            return sum;
+        });
+        measure("  find miss", [&] {
+            std::size_t found = 0;
+            for(auto key: absent) {
+                found += map.find(key) != map.end();
+            }
+            return found;
+        });
+        measure("  iterate", [&] {
+            std::uint64_t sum = 0;
+            for(const auto& [key, value]: map) {
+                sum += value;
+            }
+            return sum;
+        });
+        measure("  erase", [&] {
+            std::size_t erased = 0;
+            for(auto key: present) {
+                erased += map.erase(key);
+            }
+            return erased;
+        });
+        EXPECT_TRUE(map.empty());
+    }
+}
+
+TEST(lib, DISABLED_benchmark_flat_hash_map)
+{
+    benchmark<lib::data_structures::FlatHashMap<std::uint64_t, std::uint64_t>>("FlatHashMap");
+}
+
+TEST(lib, DISABLED_benchmark_std_unordered_map)
+{
+    benchmark<std::unordered_map<std::uint64_t, std::uint64_t>>("std::unordered_map");
+}
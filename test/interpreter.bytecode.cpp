@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <lib/interpreter/bytecode.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr auto bytecode_module() noexcept
+    {
+        using namespace lib::interpreter;
+        return lib::interpreter::module(
+            fn("u32", "foo")(param("u32", "lhs"), param("u16", "rhs"))(
+                ret(var("lhs") + var("rhs"))
+            ),
+            fn("u32", "bar")(param("u32", "lhs"), param("u32", "rhs"))(
+                var("a") = fn("foo")(var("lhs"), 5_l),
+                var("b") = fn("foo")(var("rhs"), 1_l + 2_l),
+                ret(var("a") + var("b") + 70000_l)
+            ),
+            fn("u8", "wrap")(param("u8", "x"))(
+                ret(var("x") + 1_l)
+            )
+        );
+    }
+
+    constexpr auto bytecode_bar(std::uint32_t lhs, std::uint32_t rhs)
+    {
+        const auto program = lib::interpreter::bytecode::compile(bytecode_module());
+        lib::interpreter::bytecode::Machine machine;
+        return machine(program, program.find("bar"), lhs, rhs);
+    }
+}
+
+TEST(bytecode, call)
+{
+    using namespace lib::interpreter;
+    static_assert(bytecode_bar(1, 2) == 1 + 5 + 2 + 3 + 70000);
+
+    const auto program = bytecode::compile(bytecode_module());
+    bytecode::Machine machine;
+    const auto bar = program.find("bar");
+    EXPECT_EQ(machine(program, bar, 1u, 2u), 1u + 5u + 2u + 3u + 70000u);
+    EXPECT_EQ(machine(program, bar, 0xFFFFFFFFu, 0u), (0xFFFFFFFFull + 5u + 3u + 70000u) & 0xFFFFFFFFu);
+    EXPECT_EQ(machine(program, program.find("wrap"), 255u), 0u);
+    EXPECT_EQ(program.constants.size(), 1u);
+
+    const auto unresolved = lib::interpreter::module(
+        fn("u32", "baz")(param("u32", "x"))(
+            ret(fn("foo")(var("x"), var("x")))
+        )
+    );
+    EXPECT_THROW(bytecode::compile(unresolved), std::out_of_range);
+    const auto native = lib::interpreter::module(
+        fn("u32", "baz")(param("u32", "x"))([](auto&, auto) {})
+    );
+    EXPECT_THROW(bytecode::compile(native), std::invalid_argument);
+    const auto void_value = lib::interpreter::module(
+        fn("void", "v")(param("u32", "x"))(
+            ret(var("x") + 1_l)
+        )
+    );
+    EXPECT_THROW(bytecode::compile(void_value), std::invalid_argument);
+}
+
+TEST(bytecode, symbols)
+{
+    using namespace lib::interpreter;
+    static_assert([] {
+        SymbolTable symbols;
+        return symbols.intern("a") == 0 && symbols.intern("b") == 1 && symbols.intern("a") == 0 && symbols.find("c") == no_symbol;
+    }());
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("name" + std::to_string(i));
+    }
+    SymbolTable symbols;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(symbols.intern(names[i]), i);
+    }
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(symbols.find(names[i]), i);
+        EXPECT_TRUE(symbols.name(i) == names[i]);
+    }
+    EXPECT_EQ(symbols.find("name1000"), no_symbol);
+    EXPECT_EQ(symbols.size(), names.size());
+}
+
+TEST(bytecode, overloads)
+{
+    using namespace lib::interpreter;
+    const auto program = bytecode::compile(lib::interpreter::module(
+        fn("u32", "pick")(param("u32", "x"))(
+            ret(var("x") + 1_l)
+        ),
+        fn("u32", "pick")(param("u16", "x"))(
+            ret(var("x") + 1000_l)
+        ),
+        fn("u32", "main")(param("u32", "x"))(
+            var("y") = fn("pick")(var("x")),
+            scope(
+                var("x") = 7_l,
+                var("y") = fn("pick")(var("x"))
+            ),
+            ret(var("y") + var("x"))
+        )
+    ));
+    bytecode::Machine machine;
+    EXPECT_EQ(machine(program, program.find("main"), 5u), 5u + 1u + 5u);
+}
+
+TEST(bytecode, trace)
+{
+    using namespace lib::interpreter;
+    static_assert(sizeof(bytecode::Machine) == 2 * sizeof(std::vector<bytecode::Value>));
+
+    const auto program = bytecode::compile(bytecode_module());
+    bytecode::BasicMachine<RingTracer<4>> machine;
+    EXPECT_EQ(machine(program, program.find("wrap"), 1u), 2u);
+    // LoadI, Add, Trunc, Trunc, Ret
+    EXPECT_EQ(machine.tracer().count(), 5u);
+    ASSERT_EQ(machine.tracer().size(), 4u);
+    EXPECT_EQ(machine.tracer()[0].opcode, std::uint8_t(bytecode::Op::Add));
+    EXPECT_EQ(machine.tracer()[3].opcode, std::uint8_t(bytecode::Op::Ret));
+
+    RingTracer<64> calls;
+    bytecode::BasicMachine<RingTracer<64>> traced(calls);
+    traced(program, program.find("bar"), 1u, 2u);
+    std::vector<std::uint32_t> callees;
+    for (std::size_t i = 0; i < traced.tracer().size(); ++i) {
+        if (traced.tracer()[i].opcode == std::uint8_t(bytecode::Op::Call)) {
+            callees.push_back(traced.tracer()[i].callee);
+        }
+    }
+    EXPECT_EQ(callees, (std::vector<std::uint32_t>{program.find("foo"), program.find("foo")}));
+}
+
+TEST(bytecode, optimize)
+{
+    using namespace lib::interpreter;
+    constexpr auto optimized_bar = [](std::uint32_t lhs, std::uint32_t rhs) {
+        const auto program = bytecode::optimize(bytecode::compile(bytecode_module()));
+        bytecode::Machine machine;
+        return machine(program, program.find("bar"), lhs, rhs);
+    };
+    static_assert(optimized_bar(1, 2) == bytecode_bar(1, 2));
+
+    const auto program = bytecode::compile(bytecode_module());
+    const auto optimized = bytecode::optimize(program);
+    const auto length = [](const bytecode::Program& program, std::uint32_t function) {
+        const auto begin = program.functions[function].entry;
+        const auto end = function + 1 < program.functions.size() ? program.functions[function + 1].entry : program.code.size();
+        return end - begin;
+    };
+    const auto bar = optimized.find("bar");
+    for (auto pc = optimized.functions[bar].entry; pc < optimized.functions[bar].entry + length(optimized, bar); ++pc) {
+        EXPECT_TRUE(bytecode::op(optimized.code[pc]) != bytecode::Op::Call);
+    }
+    EXPECT_TRUE(length(optimized, bar) < length(program, bar));
+
+    bytecode::Machine machine;
+    std::mt19937 random(1);
+    for (int i = 0; i < 1000; ++i) {
+        const std::uint32_t lhs = random(), rhs = random();
+        EXPECT_EQ(machine(optimized, bar, lhs, rhs), machine(program, bar, lhs, rhs));
+        EXPECT_EQ(machine(optimized, optimized.find("wrap"), lhs & 0xFFu), machine(program, program.find("wrap"), lhs & 0xFFu));
+    }
+
+    // свёртка и удаление мёртвых записей: от функции остаются LoadK и Ret
+    const auto folded = bytecode::optimize(bytecode::compile(lib::interpreter::module(
+        fn("u32", "id")(param("u32", "x"))(
+            ret(var("x"))
+        ),
+        fn("u32", "constant")(param("u32", "x"))(
+            var("unused") = fn("id")(var("x")),
+            var("a") = 70000_l + 1_l,
+            var("b") = fn("id")(var("a")),
+            ret(var("b") + 2_l + 3_l)
+        )
+    )));
+    const auto constant = folded.find("constant");
+    EXPECT_EQ(length(folded, constant), 2u);
+    EXPECT_EQ(folded.constants.size(), 1u);
+    EXPECT_EQ(machine(folded, constant, 5u), 70006u);
+}
+
+TEST(bytecode, DISABLED_benchmark)
+{
+    using namespace lib::interpreter;
+    const auto measure = [](const char* name, const bytecode::Program& program) {
+        bytecode::Machine machine;
+        const auto bar = program.find("bar");
+        std::uint64_t sum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t i = 0; i < 10'000'000; ++i) {
+            sum += machine(program, bar, i, 2u);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 10'000'000.0
+            << " ns/call, " << sum << std::endl;
+    };
+    const auto program = bytecode::compile(bytecode_module());
+    measure("bytecode", program);
+    measure("optimized", bytecode::optimize(program));
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <lib/interpreter/backend/constexpr/memory.hpp>
+#include <lib/interpreter/backend/constexpr/typeinfo.hpp>
+#include <lib/interpreter/backend/constexpr/heap.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+    using lib::interpreter::const_expr::Memory;
+    using lib::typetraits::tag_t;
+
+    template <class T>
+    constexpr T round_trip(T value)
+    {
+        std::array<std::uint8_t, 32> storage = {0};
+        Memory memory(storage);
+        memory.save(3, value);
+        return memory.load(3, tag_t<T>);
+    }
+
+    struct Pair
+    {
+        std::uint32_t first;
+        std::uint16_t second;
+    };
+}
+
+TEST(interpreter, memory)
+{
+    static_assert(round_trip<std::uint16_t>(0xBEEF) == 0xBEEF);
+    static_assert(round_trip<std::uint32_t>(0xDEADBEEF) == 0xDEADBEEF);
+    static_assert(round_trip<std::uint64_t>(0x0123456789ABCDEFull) == 0x0123456789ABCDEFull);
+    static_assert(round_trip<float>(1.5f) == 1.5f);
+
+    std::array<std::uint8_t, 64> storage = {0};
+    Memory memory(storage);
+    memory.save(0, std::uint32_t(0xDEADBEEF));
+    EXPECT_EQ(memory.load(0, tag_t<std::uint32_t>), 0xDEADBEEFu);
+    EXPECT_EQ(storage[0], 0xEFu);
+    EXPECT_EQ(storage[3], 0xDEu);
+    memory.save(5, 0x0123456789ABCDEFull);
+    EXPECT_EQ(memory.load(5, tag_t<std::uint64_t>), 0x0123456789ABCDEFull);
+    EXPECT_EQ(storage[5], 0xEFu);
+    memory.save(16, 3.25f);
+    EXPECT_EQ(memory.load(16, tag_t<float>), 3.25f);
+
+    using Trait = lib::interpreter::const_expr::TypeTrait<std::uint64_t>;
+    Trait::save(memory, 24, 42);
+    EXPECT_EQ(Trait::load(memory, 24), 42u);
+}
+
+TEST(interpreter, memory_bulk)
+{
+    std::array<std::uint8_t, 64> storage = {0};
+    Memory memory(storage);
+
+    std::uint32_t sp = 64;
+    memory.push(sp, Pair{7, 9});
+    EXPECT_EQ(sp, 64u - sizeof(Pair));
+    const std::array<std::uint8_t, 5> args = {1, 2, 3, 4, 5};
+    memory.push(sp, lib::Span<const std::uint8_t>(args));
+    EXPECT_EQ(storage[sp], 1u);
+
+    std::array<std::uint8_t, 5> popped = {0};
+    memory.pop(sp, lib::Span<std::uint8_t>(popped));
+    EXPECT_EQ(popped, args);
+    const auto pair = memory.pop(sp, tag_t<Pair>);
+    EXPECT_EQ(pair.first, 7u);
+    EXPECT_EQ(pair.second, 9u);
+    EXPECT_EQ(sp, 64u);
+
+    // изменяемая область кладётся байтами, а не как объект Span
+    std::array<std::uint8_t, 5> mutable_args = {6, 7, 8, 9, 10};
+    memory.push(sp, lib::Span<std::uint8_t>(mutable_args));
+    EXPECT_EQ(sp, 64u - 5u);
+    EXPECT_EQ(storage[59], 6u);
+    EXPECT_EQ(storage[63], 10u);
+    memory.pop(sp, lib::Span<std::uint8_t>(popped));
+    EXPECT_EQ(popped, mutable_args);
+    EXPECT_EQ(sp, 64u);
+
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        storage[i] = i;
+    }
+    memory.copy(2, 0, 6);
+    EXPECT_EQ(storage[2], 0u);
+    EXPECT_EQ(storage[7], 5u);
+    memory.copy(0, 2, 6);
+    EXPECT_EQ(storage[0], 0u);
+    EXPECT_EQ(storage[5], 5u);
+
+    constexpr auto overlap = [] {
+        std::array<std::uint8_t, 8> storage = {1, 2, 3, 4, 5, 6, 7, 8};
+        Memory memory(storage);
+        memory.copy(1, 0, 7);
+        std::uint32_t sp = 8;
+        memory.push(sp, std::uint16_t(0xAABB));
+        return storage[1] == 1 && storage[7] == 0xAA && storage[6] == 0xBB && sp == 6;
+    };
+    static_assert(overlap());
+}
+
+TEST(interpreter, heap)
+{
+    using lib::interpreter::const_expr::Heap;
+
+    constexpr auto sequence = [] {
+        Heap<256> heap;
+        const auto a = heap.alloc(4);
+        const auto b = heap.alloc(16);
+        const auto c = heap.alloc(5);
+        const bool placed = a == 0 && b == 16 && c == 8;
+        heap.free(a, 4);
+        heap.free(c, 5);
+        heap.free(b, 16);
+        const auto stats = heap.stats();
+        return placed && stats.used == 0 && stats.largest_free == 256 && heap.alloc(256) == 0;
+    };
+    static_assert(sequence());
+
+    // размер не степень двойки: [0, 96) = 64 + 32
+    Heap<96> odd;
+    EXPECT_EQ(odd.stats().largest_free, 64u);
+    EXPECT_EQ(odd.alloc(64), 0u);
+    EXPECT_EQ(odd.alloc(32), 64u);
+    EXPECT_THROW(odd.alloc(4), std::bad_alloc);
+    odd.free(64, 32);
+    odd.free(0, 64);
+    EXPECT_EQ(odd.stats().free, 96u);
+
+    Heap<1 << 16> heap;
+    std::mt19937 random(1);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> live;
+    std::vector<bool> owned(heap.size);
+    for (int step = 0; step < 20000; ++step) {
+        if (live.empty() || random() % 3 != 0) {
+            const std::uint32_t size = 1 + random() % 300;
+            std::uint32_t ptr = 0;
+            try {
+                ptr = heap.alloc(size);
+            } catch (const std::bad_alloc&) {
+                continue;
+            }
+            const std::uint32_t block = std::bit_ceil(std::max(size, heap.minsize));
+            ASSERT_EQ(ptr % block, 0u);
+            for (std::uint32_t i = ptr; i < ptr + size; ++i) {
+                ASSERT_TRUE(!owned[i]);
+                owned[i] = true;
+            }
+            live.emplace_back(ptr, size);
+        } else {
+            const auto index = random() % live.size();
+            const auto [ptr, size] = live[index];
+            for (std::uint32_t i = ptr; i < ptr + size; ++i) {
+                owned[i] = false;
+            }
+            heap.free(ptr, size);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    const auto stats = heap.stats();
+    EXPECT_GT(stats.used, 0u);
+    EXPECT_TRUE(stats.requested <= stats.used);
+    EXPECT_EQ(stats.free + stats.used, heap.size);
+    EXPECT_TRUE(stats.fragmentation() >= 0.0 && stats.fragmentation() < 1.0);
+    for (const auto& [ptr, size]: live) {
+        heap.free(ptr, size);
+    }
+    EXPECT_EQ(heap.stats().largest_free, heap.size);
+    EXPECT_EQ(heap.stats().fragmentation(), 0.0);
+}
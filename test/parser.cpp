@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 
 #include <lib/parser.hpp>
+#include <lib/parser.stream.hpp>
+#include <lib/parser.lr.hpp>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
 #include <tuple>
 
 namespace utils
@@ -106,6 +112,192 @@ TEST(parser, extended)
 	}
 }
 
+TEST(parser, skip)
+{
+	const auto& match = lib::match;
+	std::string text(1000, 'a');
+	for(std::size_t i = 0; i < text.size(); ++i)
+		text[i] = "abcxyz"[i % 6];
+	text += "  \t\t  ;";
+	{
+		constexpr auto word = *match('a', 'z');
+		const char* it = text.data();
+		const auto result = word(it, text.data() + text.size());
+		EXPECT_TRUE(result && result->size() == 1000);
+		EXPECT_EQ(it, text.data() + 1000);
+		EXPECT_TRUE(result && (*result)[999] == text[999]);
+	}
+	{
+		constexpr auto space = +match[" \t"];
+		const char* it = text.data() + 1000;
+		const auto result = space(it, text.data() + text.size());
+		EXPECT_TRUE(result && result->size() == 6);
+		EXPECT_TRUE(result && (*result)[0] == 0 && (*result)[2] == 1);
+		EXPECT_EQ(*it, ';');
+		it = text.data();
+		EXPECT_TRUE(!space(it, text.data() + text.size()));
+		EXPECT_EQ(it, text.data());
+	}
+	{
+		constexpr auto regex = match["xyz"] & *match["abcxyz"] & +match[" \t"] & match(";");
+		const char* it = text.data() + 3;
+		EXPECT_TRUE(regex(it, text.data() + text.size()));
+		EXPECT_EQ(it, text.data() + text.size());
+	}
+	{
+		// знаковые границы: [-128, 'a'] содержит байты 0x80..0xFF, а [5, -5] пуст
+		std::vector<signed char> bytes(64, static_cast<signed char>(0x90));
+		bytes[40] = 'a';
+		bytes[41] = 'b';
+		const auto high = match(static_cast<signed char>('a'), static_cast<signed char>(-128));
+		EXPECT_EQ(high.skip(bytes.data(), bytes.data() + bytes.size()), bytes.data() + 41);
+		const lib::regex<lib::match_range_t<signed char>> empty(5, -5);
+		EXPECT_EQ(empty.skip(bytes.data(), bytes.data() + bytes.size()), bytes.data());
+		const signed char* it = bytes.data() + 41;
+		EXPECT_TRUE(!empty(it, bytes.data() + bytes.size()));
+	}
+}
+
+TEST(parser, dfa)
+{
+	const auto& match = lib::match;
+	{
+		constexpr auto symbol = match('a', 'z') | match('A', 'Z') | match("_");
+		constexpr auto number = match["1234567890"];
+		const auto regex = lib::regex_compile(symbol & *(symbol | number));
+		EXPECT_TRUE(regex("some_value"));
+		EXPECT_TRUE(regex("_"));
+		EXPECT_TRUE(regex("LegalIdentifier"));
+		EXPECT_TRUE(!regex("122_bytes"));
+		EXPECT_TRUE(!regex(" value"));
+
+		const char text[] = "value_1 + 2";
+		const char* it = text;
+		EXPECT_TRUE(regex(it, text + sizeof(text) - 1));
+		EXPECT_EQ(it, text + 7);
+	}
+	{
+		constexpr auto regex = match("ab") & +match("c") & !match("d");
+		const auto dfa = lib::regex_compile(regex);
+		for(const auto& text: {"abc", "abcd", "abcccd", "ab", "abd", "abce", "abcdd"}) {
+			const auto* begin = text;
+			const auto* end = text + std::char_traits<char>::length(text);
+			auto rit = begin;
+			auto dit = begin;
+			const bool full = bool(regex(rit, end)) && rit == end;
+			EXPECT_EQ(full, dfa(dit, end) && dit == end);
+		}
+	}
+	{
+		// ДКА не зависит от числа альтернатив и находит самое длинное совпадение
+		const auto keyword = lib::regex_compile(match("in") | match("int") | match("if") | match("interface"));
+		const char text[] = "interfaces";
+		const char* it = text;
+		EXPECT_TRUE(keyword(it, text + sizeof(text) - 1));
+		EXPECT_EQ(it, text + 9);
+		EXPECT_TRUE(!keyword("inter"));
+	}
+	{
+		constexpr auto identifier = lib::regex_compile([] {
+			const auto& match = lib::match;
+			const auto symbol = match('a', 'z') | match("_");
+			return symbol & *(symbol | match('0', '9'));
+		});
+		static_assert(identifier("snake_case_1"));
+		static_assert(!identifier("1st"));
+		static_assert(identifier.states() == 3);
+	}
+}
+
+TEST(parser, stream)
+{
+	const auto& match = lib::match;
+	constexpr auto symbol = match('a', 'z') | match("_");
+	constexpr auto number = +match('0', '9');
+	constexpr auto space = +match[" \n"];
+	const auto dfa = lib::regex_compile((symbol & *(symbol | match('0', '9'))) | number | space | match("<=") | match("<"));
+
+	std::string input;
+	std::mt19937 random(42);
+	const char* words[] = {"value_1", " ", "42", "<=", "\n", "<", "x", "  "};
+	for(int i = 0; i < 2000; ++i)
+		input += words[random() % std::size(words)];
+
+	// незавершённая лексема держит не больше самой длинной лексемы и одного блока
+	std::size_t longest = input.size();
+	const auto tokenize = [&](std::size_t chunk) {
+		std::vector<std::string> tokens;
+		lib::regex_stream stream(dfa);
+		const auto collect = [&](lib::buffer::Chain<const char>&& token) {
+			std::string text(token.size(), '\0');
+			token.copy(lib::buffer::ViewImpl<char>(text.data(), text.size()));
+			tokens.push_back(std::move(text));
+		};
+		for(std::size_t i = 0; i < input.size(); i += chunk) {
+			EXPECT_TRUE(stream.feed(std::string_view(input).substr(i, chunk), collect));
+			EXPECT_TRUE(stream.buffered() < longest + chunk);
+		}
+		EXPECT_TRUE(stream.finish(collect));
+		return tokens;
+	};
+	const auto whole = tokenize(input.size());
+	EXPECT_GT(whole.size(), 1000u);
+	longest = 0;
+	for(const auto& token: whole)
+		longest = std::max(longest, token.size());
+	for(std::size_t chunk: {1, 2, 3, 7, 64, 4096})
+		EXPECT_TRUE(tokenize(chunk) == whole);
+}
+
+TEST(parser, lr)
+{
+	// конфиг "key = value;" по блокам: лексемы из regex_stream, разбор - lr_parser
+	constexpr auto grammar = lib::lr_compile([] {
+		return lib::lr_grammar{
+			"config := | config entry",
+			"entry := word = value ;",
+			"value := word | number",
+		};
+	});
+	const auto& match = lib::match;
+	const auto lexer = lib::regex_compile(+match('a', 'z') | +match('0', '9') | match("=") | match(";") | +match[" \n"]);
+
+	using Value = std::string;
+	std::map<std::string, std::string> config;
+	const auto reduce = [&](std::size_t production, std::span<Value> rhs) -> Value {
+		if(grammar.production_lhs(production) == grammar.symbol("entry"))
+			config[rhs[0]] = rhs[2];
+		return rhs.size() == 1 ? rhs[0] : Value();
+	};
+
+	lib::lr_parser<Value, std::remove_const_t<decltype(grammar)>> parser(grammar);
+	lib::regex_stream stream(lexer);
+	bool valid = true;
+	const auto on_token = [&](lib::buffer::Chain<const char>&& token) {
+		std::string text(token.size(), '\0');
+		token.copy(lib::buffer::ViewImpl<char>(text.data(), text.size()));
+		if(text[0] == ' ' || text[0] == '\n')
+			return;
+		const auto terminal = text[0] >= '0' && text[0] <= '9' ? grammar.symbol("number")
+			: text[0] >= 'a' && text[0] <= 'z' ? grammar.symbol("word")
+			: grammar.symbol(text);
+		valid = valid && parser.push(terminal, std::move(text), reduce);
+	};
+	for(std::string_view chunk: {"name = ser", "ver;\nport", " = 8080;\n", "mode=fast;"})
+		EXPECT_TRUE(stream.feed(chunk, on_token));
+	EXPECT_TRUE(stream.finish(on_token));
+	EXPECT_TRUE(valid);
+	EXPECT_TRUE(parser.finish(reduce).has_value());
+	EXPECT_EQ(config.size(), 3u);
+	EXPECT_TRUE(config["name"] == "server");
+	EXPECT_TRUE(config["port"] == "8080");
+	EXPECT_TRUE(config["mode"] == "fast");
+
+	lib::lr_parser<Value, std::remove_const_t<decltype(grammar)>> broken(grammar);
+	EXPECT_TRUE(broken.push(grammar.symbol("word"), "key", reduce));
+	EXPECT_TRUE(!broken.push(grammar.symbol(";"), ";", reduce));
+}
+
 namespace {
 
 	struct null_array_t {} constexpr null_array;